@@ -0,0 +1,84 @@
+#include "big_accumulator.h"
+
+namespace {
+// every addition moves a slot by less than 2^32, and after propagate() slots are below 2^32
+// in magnitude, so this many additions cannot overflow one
+uint32_t const PENDING_LIMIT = uint32_t(1) << 30u;
+int64_t const LIMB = int64_t(1) << 32u;
+
+// Carries of the slots from the lowest up; leaves limbs in [0, 2^32) and returns the carry out.
+int64_t carry_through(int64_t *s, size_t n) {
+    int64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t t = s[i] + carry;
+        s[i] = static_cast<uint32_t>(t);
+        carry = (t - s[i]) / LIMB;
+    }
+    return carry;
+}
+}
+
+big_accumulator::big_accumulator() : pending_(0) {}
+
+big_accumulator& big_accumulator::operator+=(big_integer const& x) {
+    add(x, x.sign);
+    return *this;
+}
+
+big_accumulator& big_accumulator::operator-=(big_integer const& x) {
+    add(x, !x.sign);
+    return *this;
+}
+
+void big_accumulator::add(big_integer const& x, bool negative) {
+    if (pending_ == PENDING_LIMIT) {
+        propagate();
+    }
+    ++pending_;
+    size_t n = x.data_.size();
+    if (slots_.size() < n) {
+        slots_.resize(n);
+    }
+    uint32_t const *d = x.data_.data();
+    int64_t *s = slots_.data();
+    int64_t factor = negative ? -1 : 1;
+    for (size_t i = 0; i < n; ++i) {
+        s[i] += factor * d[i];
+    }
+}
+
+// The top slot keeps the sign of the sum and is only split once it has outgrown a limb.
+void big_accumulator::propagate() {
+    size_t n = slots_.size();
+    slots_[n - 1] += carry_through(slots_.data(), n - 1);
+    if (slots_[n - 1] >= LIMB || slots_[n - 1] <= -LIMB) {
+        slots_.push_back(carry_through(slots_.data() + n - 1, 1));
+    }
+    pending_ = 0;
+}
+
+big_integer big_accumulator::value() const {
+    std::vector<int64_t> s = slots_;
+    int64_t carry = carry_through(s.data(), s.size());
+    big_integer res;
+    size_t n = s.size();
+    res.data_.resize(n + 2);
+    uint32_t *r = res.data_.data();
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = static_cast<uint32_t>(s[i]);
+    }
+    r[n] = static_cast<uint32_t>(carry);
+    r[n + 1] = static_cast<uint32_t>(carry >> 32);
+    res.sign = carry < 0;
+    if (res.sign) {
+        // the limbs are the two's complement of the magnitude
+        uint64_t c = 1;
+        for (size_t i = 0; i < n + 2; ++i) {
+            c += static_cast<uint32_t>(~r[i]);
+            r[i] = static_cast<uint32_t>(c);
+            c >>= 32u;
+        }
+    }
+    res.remove_zeros();
+    return res;
+}
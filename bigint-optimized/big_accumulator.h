@@ -0,0 +1,29 @@
+#ifndef BIG_ACCUMULATOR_H
+#define BIG_ACCUMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "big_integer.h"
+
+// Running sum kept as signed 64-bit slots, one per limb position, so that adding x touches only
+// the limbs of x: carries stay in their slots until value() or, every 2^30 additions, a pass
+// that brings the slots back into limb range. Negative inputs are subtracted slot by slot
+// in the same loop.
+struct big_accumulator {
+    big_accumulator();
+
+    big_accumulator& operator+=(big_integer const& x);
+    big_accumulator& operator-=(big_integer const& x);
+
+    big_integer value() const;
+
+private:
+    std::vector<int64_t> slots_;
+    uint32_t pending_;
+
+    void add(big_integer const& x, bool negative);
+    void propagate();
+};
+
+#endif // BIG_ACCUMULATOR_H
@@ -1,10 +1,12 @@
 #include "big_integer.h"
 
+#include <cassert>
 #include <cstring>
 #include <stdexcept>
 #include <climits>
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
 using uint128 = unsigned __int128;
 
@@ -12,7 +14,16 @@ const uint128 BASE = static_cast<uint128>(UINT32_MAX) + 1;
 
 const size_t STEP = 9;
 const uint32_t BASE_STRING = 1000000000;
-const big_integer ZERO = big_integer(0);
+
+namespace {
+// number of limbs of the n-limb p without its leading zeros, at least one
+size_t significant_limbs(uint32_t const *p, size_t n) {
+    while (n > 1 && p[n - 1] == 0) {
+        --n;
+    }
+    return n;
+}
+}
 
 big_integer::big_integer() : sign(false), data_(1, 0) {}
 
@@ -28,6 +39,12 @@ big_integer::big_integer(int a) : sign(a < 0) {
 
 big_integer::big_integer(uint32_t a) : sign(false), data_(1, a) {}
 
+big_integer::big_integer(uint64_t magnitude, bool negative) : big_integer() {
+    set_small(magnitude, negative);
+}
+
+big_integer::big_integer(storage_t::borrowed_limbs limbs, bool negative) : sign(negative), data_(limbs) {}
+
 big_integer::big_integer(std::string const& str) : big_integer() {
     for (size_t i = (str[0] == '-'); i < str.size(); i += STEP) {
         uint32_t t = 0;
@@ -52,115 +69,295 @@ big_integer::~big_integer() = default;
 big_integer& big_integer::operator=(big_integer const& other) = default;
 
 bool operator==(big_integer const& a, big_integer const& b) {
+    assert(a.normalized() && b.normalized());
     return (a.sign == b.sign) && (a.data_ == b.data_);
 }
 
+namespace {
+// final step of MurmurHash3, spreading every input bit over the whole word
+uint64_t fmix64(uint64_t h) {
+    h ^= h >> 33u;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33u;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33u);
+}
+}
+
+uint64_t hash_value(big_integer const& a) {
+    assert(a.normalized());
+    uint32_t const *d = a.data_.data();
+    size_t n = a.data_.size(), i = 0;
+    uint64_t h = static_cast<uint64_t>(n) << 1u | a.sign;
+    // two limbs at a time, a multiply and a shift each
+    for (; i + 1 < n; i += 2) {
+        h = (h ^ (d[i] | static_cast<uint64_t>(d[i + 1]) << 32u)) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29u;
+    }
+    if (i < n) {
+        h = (h ^ d[i]) * 0x9e3779b97f4a7c15ull;
+    }
+    return fmix64(h);
+}
+
 bool operator!=(big_integer const& a, big_integer const& b) {
     return !(a == b);
 }
 
-bool operator<(big_integer const& a, big_integer const& b) {
-    if (a.sign ^ b.sign) {
-        return a.sign;
+int compare_abs(big_integer const& a, big_integer const& b) {
+    assert(a.normalized() && b.normalized());
+    size_t n = a.data_.size(), m = b.data_.size();
+    if (n != m) {
+        return n < m ? -1 : 1;
     }
-    if (a.data_.size() != b.data_.size()) {
-        return a.sign ^ (a.data_.size() < b.data_.size());
+    uint32_t const *x = a.data_.data(), *y = b.data_.data();
+    if (x == y) {
+        return 0;
     }
-    for (size_t i = a.data_.size(); i > 0; --i) {
-        if (a.data_[i - 1] != b.data_[i - 1]) {
-            return a.sign ^ (a.data_[i - 1] < b.data_[i - 1]);
+    for (size_t i = n; i > 0; --i) {
+        if (x[i - 1] != y[i - 1]) {
+            return x[i - 1] < y[i - 1] ? -1 : 1;
         }
     }
-    return false;
+    return 0;
+}
+
+int compare(big_integer const& a, big_integer const& b) {
+    if (a.sign ^ b.sign) {
+        return a.sign ? -1 : 1;
+    }
+    int res = compare_abs(a, b);
+    return a.sign ? -res : res;
+}
+
+bool operator<(big_integer const& a, big_integer const& b) {
+    return compare(a, b) < 0;
 }
 
 bool operator>(big_integer const& a, big_integer const& b) {
-    return !(a < b || a == b);
+    return compare(a, b) > 0;
 }
 
 bool operator<=(big_integer const& a, big_integer const& b) {
-    return !(a > b);
+    return compare(a, b) <= 0;
 }
 
 bool operator>=(big_integer const& a, big_integer const& b) {
-    return !(a < b);
+    return compare(a, b) >= 0;
 }
 
 uint32_t overflow(uint64_t n) {
     return (n >> 32u);
 }
 
-big_integer& big_integer::operator+=(big_integer const& rhs) {
-    if (sign) {
-        *this = rhs.sign ? -(-*this + -rhs) : (rhs - -*this);
-        return *this;
-    } else {
-        if (rhs.sign) {
-            *this -= -rhs;
-            return *this;
-        }
-    }
-    if (*this < rhs) {
-        *this = rhs + *this;
-        return *this;
+void big_integer::add_abs(big_integer const& rhs) {
+    size_t m = rhs.data_.size();
+    if (data_.size() < m) {
+        data_.resize(m);
     }
+    size_t n = data_.size();
+    uint32_t *r = data_.data();
+    uint32_t const *b = rhs.data_.data();
     uint32_t of = 0;
-    for (size_t i = 0; i < data_.size(); ++i) {
-        uint32_t t = i < rhs.data_.size() ? rhs.data_[i] : 0;
-        uint64_t temp = static_cast<uint64_t>(data_[i]) + t + of;
-        data_[i] = temp;
-        of = temp > UINT32_MAX;
+    for (size_t i = 0; i < m; ++i) {
+        uint64_t temp = static_cast<uint64_t>(r[i]) + b[i] + of;
+        r[i] = temp;
+        of = overflow(temp);
+    }
+    for (size_t i = m; i < n && of; ++i) {
+        of = ++r[i] == 0;
     }
     if (of) {
         data_.push_back(of);
     }
+}
+
+// |*this| = ||*this| - |rhs||, where reversed tells that |rhs| is the larger one
+void big_integer::sub_abs(big_integer const& rhs, bool reversed) {
+    size_t m = rhs.data_.size();
+    if (data_.size() < m) {
+        data_.resize(m);
+    }
+    size_t n = data_.size();
+    uint32_t *r = data_.data();
+    uint32_t const *b = rhs.data_.data();
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < m; ++i) {
+        uint64_t diff = reversed ? static_cast<uint64_t>(b[i]) - r[i] - borrow
+                                 : static_cast<uint64_t>(r[i]) - b[i] - borrow;
+        r[i] = diff;
+        borrow = diff >> 63u;
+    }
+    for (size_t i = m; i < n && borrow; ++i) {
+        borrow = r[i]-- == 0;
+    }
     remove_zeros();
+}
+
+big_integer& big_integer::operator+=(big_integer const& rhs) {
+    if (sign == rhs.sign) {
+        add_abs(rhs);
+        return *this;
+    }
+    int cmp = compare_abs(*this, rhs);
+    if (cmp == 0) {
+        return *this = 0;
+    }
+    sub_abs(rhs, cmp < 0);
+    if (cmp < 0) {
+        sign = rhs.sign;
+    }
     return *this;
 }
 
 big_integer& big_integer::operator-=(big_integer const& rhs) {
-    if (sign) {
-        *this = rhs.sign ? (-rhs - -*this) : -(-*this + rhs);
+    if (sign != rhs.sign) {
+        add_abs(rhs);
         return *this;
-    } else {
-        if (rhs.sign) {
-            *this += -rhs;
-            return *this;
-        }
     }
-    if (*this < rhs) {
-        *this = -(rhs - *this);
-        return *this;
+    int cmp = compare_abs(*this, rhs);
+    if (cmp == 0) {
+        return *this = 0;
     }
-    bool carry = false;
-    for (size_t i = 0; i < data_.size(); ++i) {
-        uint32_t t = rhs.data_.size() > i ? rhs.data_[i] : 0;
-        if (data_[i] < carry + t) {
-            data_[i] = static_cast<uint64_t>(UINT32_MAX) - t - carry + data_[i] + 1;
-            carry = true;
-        } else {
-            data_[i] -= carry + t;
-            carry = false;
-        }
+    sub_abs(rhs, cmp < 0);
+    if (cmp < 0) {
+        sign = !rhs.sign;
     }
-    remove_zeros();
     return *this;
 }
 
-big_integer& big_integer::operator*=(big_integer const& rhs) {
-    big_integer res;
-    res.data_.resize(data_.size() + rhs.data_.size(), 0);
-    res.sign = sign ^ rhs.sign;
-    uint32_t of = 0;
-    for (size_t i = 0; i < data_.size(); ++i) {
-        for (size_t j = 0; j < rhs.data_.size() || of > 0; ++j) {
-            uint64_t temp = res.data_[i + j] + static_cast<uint64_t>(data_[i]) * (j < rhs.data_.size() ? rhs.data_[j] : 0) + of;
+namespace {
+// Karatsuba pays off from this many limbs per operand, and its three sub-products are
+// handed to other threads from PARALLEL_MUL_LIMBS on.
+size_t const KARATSUBA_LIMBS = 32;
+size_t const PARALLEL_MUL_LIMBS = 1024;
+
+// r[0, n + m) = a * b
+void mul_basecase(uint32_t *r, uint32_t const *a, size_t n, uint32_t const *b, size_t m) {
+    std::fill(r, r + m, 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t of = 0;
+        for (size_t j = 0; j < m; ++j) {
+            uint64_t temp = r[i + j] + static_cast<uint64_t>(a[i]) * b[j] + of;
             of = overflow(temp);
-            res.data_[i + j] = temp;
+            r[i + j] = temp;
         }
+        r[i + m] = of;
     }
-    *this = res;
-    remove_zeros();
+}
+
+// r[0, n) = |x - y| for x and y of at most n limbs, returns whether x < y
+bool abs_diff(uint32_t *r, uint32_t const *x, size_t xn, uint32_t const *y, size_t yn, size_t n) {
+    bool less = false;
+    for (size_t i = n; i > 0; --i) {
+        uint32_t xi = i <= xn ? x[i - 1] : 0, yi = i <= yn ? y[i - 1] : 0;
+        if (xi != yi) {
+            less = xi < yi;
+            break;
+        }
+    }
+    if (less) {
+        std::swap(x, y);
+        std::swap(xn, yn);
+    }
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t d = static_cast<uint64_t>(i < xn ? x[i] : 0) - (i < yn ? y[i] : 0) - borrow;
+        r[i] = static_cast<uint32_t>(d);
+        borrow = static_cast<uint32_t>(d >> 63u);
+    }
+    return less;
+}
+
+// r[0, n) += a[0, m) for m <= n, returns the carry out of r
+uint32_t add_into(uint32_t *r, size_t n, uint32_t const *a, size_t m) {
+    uint64_t c = 0;
+    for (size_t i = 0; i < n && (i < m || c); ++i) {
+        c += static_cast<uint64_t>(r[i]) + (i < m ? a[i] : 0);
+        r[i] = static_cast<uint32_t>(c);
+        c >>= 32u;
+    }
+    return static_cast<uint32_t>(c);
+}
+
+void sub_from(uint32_t *r, size_t n, uint32_t const *a, size_t m) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < n && (i < m || borrow); ++i) {
+        uint64_t d = static_cast<uint64_t>(r[i]) - (i < m ? a[i] : 0) - borrow;
+        r[i] = static_cast<uint32_t>(d);
+        borrow = static_cast<uint32_t>(d >> 63u);
+    }
+}
+
+// r[0, 2n) = a * b for n-limb a and b. With a = a1 B^h + a0 and b = b1 B^h + b0 the middle
+// product a0 b1 + a1 b0 is a0 b0 + a1 b1 + (a0 - a1)(b1 - b0), three multiplications instead of four.
+void mul_karatsuba(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n, unsigned threads) {
+    if (n < KARATSUBA_LIMBS) {
+        mul_basecase(r, a, n, b, n);
+        return;
+    }
+    size_t h = n / 2, hh = n - h;
+    scratch_limbs da(hh), db(hh), p(2 * hh);
+    bool negative = abs_diff(da.data(), a, h, a + h, hh, hh) != abs_diff(db.data(), b + h, hh, b, h, hh);
+    bool parallel = threads > 1 && n >= PARALLEL_MUL_LIMBS;
+    unsigned low = parallel ? std::max(1u, threads / 3) : threads;
+    unsigned rest = parallel ? threads - low : threads;
+    unsigned high = parallel ? std::max(1u, rest / 2) : threads;
+    big_integer_detail::fork_join(parallel, [&] {
+        mul_karatsuba(r, a, b, h, low);
+    }, [&] {
+        big_integer_detail::fork_join(parallel && rest > 1, [&] {
+            mul_karatsuba(r + 2 * h, a + h, b + h, hh, high);
+        }, [&] {
+            mul_karatsuba(p.data(), da.data(), db.data(), hh, parallel && rest > 1 ? rest - high : rest);
+        });
+    });
+    scratch_limbs mid(2 * hh + 1);
+    std::copy(r + 2 * h, r + 2 * n, mid.data());
+    add_into(mid.data(), 2 * hh + 1, r, 2 * h);
+    if (negative) {
+        sub_from(mid.data(), 2 * hh + 1, p.data(), 2 * hh);
+    } else {
+        add_into(mid.data(), 2 * hh + 1, p.data(), 2 * hh);
+    }
+    add_into(r + h, 2 * n - h, mid.data(), 2 * hh + 1);
+}
+
+// r[0, n + m) = a * b for n >= m, the longer operand cut into pieces of m limbs
+void mul_any(uint32_t *r, uint32_t const *a, size_t n, uint32_t const *b, size_t m, unsigned threads) {
+    if (m < KARATSUBA_LIMBS) {
+        mul_basecase(r, a, n, b, m);
+        return;
+    }
+    if (n == m) {
+        mul_karatsuba(r, a, b, n, threads);
+        return;
+    }
+    std::fill(r, r + n + m, 0);
+    scratch_limbs t(2 * m);
+    for (size_t i = 0; i < n; i += m) {
+        size_t len = std::min(m, n - i);
+        mul_any(t.data(), b, m, a + i, len, threads);
+        add_into(r + i, n + m - i, t.data(), m + len);
+    }
+}
+}
+
+big_integer& big_integer::operator*=(big_integer const& rhs) {
+    size_t n = data_.size(), m = rhs.data_.size();
+    scratch_limbs res(n + m);
+    uint32_t const *a = std::as_const(data_).data(), *b = rhs.data_.data();
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    mul_any(res.data(), a, n, b, m, m < PARALLEL_MUL_LIMBS ? 1 : get_big_integer_threads());
+    // only the limbs that stay are copied back
+    size_t size = significant_limbs(res.data(), n + m);
+    sign = (sign ^ rhs.sign) && (size > 1 || res[0] != 0);
+    data_.resize(size);
+    std::copy(res.data(), res.data() + size, data_.data());
+    assert(normalized());
     return *this;
 }
 
@@ -168,61 +365,363 @@ uint64_t shift(uint32_t a) {
     return static_cast<uint64_t>(a) << 32u;
 }
 
-big_integer& big_integer::div_by_short(uint32_t a) {
-    big_integer res;
-    res.data_.resize(data_.size());
-    uint32_t carry = 0;
-    for (size_t i = data_.size(); i > 0; --i) {
-        uint64_t temp = data_[i - 1] + shift(carry);
-        res.data_[i - 1] = temp / a;
-        carry = temp % a;
+size_t big_integer::bit_length() const {
+    size_t n = data_.size();
+    uint32_t top = data_[n - 1];
+    return top == 0 ? 0 : 32 * (n - 1) + 32 - __builtin_clz(top);
+}
+
+bool big_integer::is_zero() const {
+    return data_.size() == 1 && data_[0] == 0;
+}
+
+void big_integer::set_small(uint64_t magnitude, bool negative) {
+    data_.resize(overflow(magnitude) ? 2 : 1);
+    uint32_t *r = data_.data();
+    r[0] = magnitude;
+    if (overflow(magnitude)) {
+        r[1] = overflow(magnitude);
+    }
+    sign = negative && magnitude != 0;
+}
+
+big_integer& big_integer::add_small(uint64_t magnitude, bool negative) {
+    size_t n = data_.size();
+    if (n <= 2) {
+        uint32_t const *digits = std::as_const(data_).data();
+        uint64_t value = n == 2 ? shift(digits[1]) | digits[0] : digits[0];
+        if (sign == negative) {
+            uint64_t sum = value + magnitude;
+            if (sum < value) {
+                data_.resize(3);
+                uint32_t *r = data_.data();
+                r[0] = sum;
+                r[1] = overflow(sum);
+                r[2] = 1;
+            } else {
+                set_small(sum, sign);
+            }
+        } else if (value >= magnitude) {
+            set_small(value - magnitude, sign);
+        } else {
+            set_small(magnitude - value, negative);
+        }
+        return *this;
+    }
+    uint32_t *r = data_.data();
+    if (sign == negative) {
+        uint64_t temp = static_cast<uint64_t>(r[0]) + static_cast<uint32_t>(magnitude);
+        r[0] = temp;
+        temp = static_cast<uint64_t>(r[1]) + overflow(magnitude) + overflow(temp);
+        r[1] = temp;
+        uint32_t of = overflow(temp);
+        for (size_t i = 2; i < n && of; ++i) {
+            of = ++r[i] == 0;
+        }
+        if (of) {
+            data_.push_back(of);
+        }
+    } else {
+        // |*this| has at least three limbs, so it is the larger one
+        uint64_t diff = static_cast<uint64_t>(r[0]) - static_cast<uint32_t>(magnitude);
+        r[0] = diff;
+        diff = static_cast<uint64_t>(r[1]) - overflow(magnitude) - (diff >> 63u);
+        r[1] = diff;
+        uint32_t borrow = diff >> 63u;
+        for (size_t i = 2; i < n && borrow; ++i) {
+            borrow = r[i]-- == 0;
+        }
+        remove_zeros();
     }
-    *this = res;
+    return *this;
+}
+
+big_integer& big_integer::mul_small(uint64_t magnitude, bool negative) {
+    if (magnitude == 0) {
+        return *this = 0;
+    }
+    size_t n = data_.size();
+    uint32_t lo = magnitude, hi = overflow(magnitude);
+    data_.resize(n + 2);
+    uint32_t *r = data_.data();
+    uint32_t prev = 0;
+    uint128 carry = 0;
+    for (size_t i = 0; i < n + 2; ++i) {
+        uint32_t cur = r[i];
+        uint128 temp = static_cast<uint128>(static_cast<uint64_t>(cur) * lo) + static_cast<uint64_t>(prev) * hi + carry;
+        r[i] = temp;
+        carry = temp >> 32u;
+        prev = cur;
+    }
+    sign ^= negative;
     remove_zeros();
     return *this;
 }
 
-big_integer& big_integer::operator/=(big_integer const& rhs) {
-    if (abs(*this) < abs(rhs)) {
-        *this = 0;
-        return *this;
+divisor_1::divisor_1(uint32_t d) : d(d), norm_shift(__builtin_clz(d)) {
+    normalized = d << norm_shift;
+    reciprocal = UINT64_MAX / normalized - BASE;
+}
+
+uint32_t divisor_1::value() const {
+    return d;
+}
+
+// Moller-Granlund 2/1 division: (u1 u0) / normalized for u1 < normalized, with no hardware div.
+uint32_t divisor_1::divrem_2_1(uint32_t &r, uint32_t u1, uint32_t u0) const {
+    uint64_t q = static_cast<uint64_t>(reciprocal) * u1 + (shift(u1) | u0);
+    uint32_t q1 = overflow(q) + 1, q0 = q;
+    r = u0 - q1 * normalized;
+    if (r > q0) {
+        --q1;
+        r += normalized;
     }
-    if (sign ^ rhs.sign) {
-        *this = sign ? -(-*this / rhs) : -(*this / -rhs);
-        return *this;
+    if (r >= normalized) {
+        ++q1;
+        r -= normalized;
     }
-    if (rhs.data_.size() == 1) {
-        *this = div_by_short(rhs.data_[0]);
-        return *this;
+    return q1;
+}
+
+uint32_t divisor_1::divrem(uint32_t *q, uint32_t const *u, size_t n) const {
+    uint32_t r = 0;
+    if (norm_shift == 0) {
+        for (size_t i = n; i > 0; --i) {
+            q[i - 1] = divrem_2_1(r, r, u[i - 1]);
+        }
+        return r;
+    }
+    r = u[n - 1] >> (32 - norm_shift);
+    for (size_t i = n; i > 0; --i) {
+        uint32_t low = i > 1 ? u[i - 2] >> (32 - norm_shift) : 0;
+        q[i - 1] = divrem_2_1(r, r, (u[i - 1] << norm_shift) | low);
+    }
+    return r >> norm_shift;
+}
+
+uint32_t divrem(big_integer& a, divisor_1 const& d) {
+    uint32_t *digits = a.data_.data();
+    uint32_t r = d.divrem(digits, digits, a.data_.size());
+    a.remove_zeros();
+    return r;
+}
+
+// Replaces the magnitude with its quotient by d and returns the remainder.
+uint64_t big_integer::divrem_small(uint64_t d) {
+    uint32_t *digits = data_.data();
+    if (!overflow(d)) {
+        return divisor_1(d).divrem(digits, digits, data_.size());
+    }
+    uint64_t carry = 0;
+    for (size_t i = data_.size(); i > 0; --i) {
+        uint128 temp = (static_cast<uint128>(carry) << 32u) | digits[i - 1];
+        digits[i - 1] = temp / d;
+        carry = temp % d;
+    }
+    return carry;
+}
+
+int big_integer::compare_small(big_integer const& a, uint64_t magnitude, bool negative) {
+    negative = negative && magnitude != 0;
+    if (a.sign != negative) {
+        return a.sign ? -1 : 1;
+    }
+    int res;
+    if (a.data_.size() > 2) {
+        res = 1;
+    } else {
+        uint64_t value = a.data_.size() == 2 ? shift(a.data_[1]) | a.data_[0] : a.data_[0];
+        res = value < magnitude ? -1 : value > magnitude;
+    }
+    return a.sign ? -res : res;
+}
+
+namespace {
+uint32_t mul_by_short(uint32_t *res, uint32_t const *a, size_t n, uint32_t b) {
+    uint32_t of = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t temp = static_cast<uint64_t>(a[i]) * b + of;
+        res[i] = temp;
+        of = overflow(temp);
+    }
+    return of;
+}
+
+uint32_t trial(uint32_t const *r, uint32_t const *d, size_t k, size_t m) {
+    size_t km = k + m;
+    uint128 r3 = (r[km] * BASE + r[km - 1]) * BASE + r[km - 2];
+    uint64_t d2 = d[m - 1] * BASE + d[m - 2];
+    return std::min(r3 / d2, BASE - 1);
+}
+
+bool smaller(uint32_t const *r, uint32_t const *dq, size_t k, size_t m) {
+    size_t i = m, j = 0;
+    while (i != j) {
+        if (r[i + k] != dq[i]) {
+            j = i;
+        } else {
+            --i;
+        }
+    }
+    return r[i + k] < dq[i];
+}
+
+void difference(uint32_t *r, uint32_t const *dq, size_t k, size_t m) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i <= m; ++i) {
+        uint64_t diff = BASE + r[i + k] - dq[i] - borrow;
+        r[i + k] = diff;
+        borrow = 1 - overflow(diff);
     }
+}
+}
+
+// Algorithm D on magnitudes for |rhs| of at least two limbs and |*this| >= |rhs|.
+// Leaves the quotient or, if remainder is set, the remainder in the magnitude of *this.
+void big_integer::long_divide(big_integer const& rhs, bool remainder) {
     size_t n = data_.size(), m = rhs.data_.size();
     uint32_t f = BASE / (static_cast<uint64_t>(rhs.data_[m - 1]) + 1);
-    big_integer r = *this * f;
-    big_integer d = rhs * f;
-    big_integer q;
-    q.data_.resize(n - m + 1);
-    r.data_.push_back(0);
+    scratch_limbs r(n + 1), d(m), dq(m + 1), q(n - m + 1);
+    r[n] = mul_by_short(r.data(), std::as_const(data_).data(), n, f);
+    mul_by_short(d.data(), rhs.data_.data(), m, f);
     for (size_t k = n - m + 1; k > 0; --k) {
-        uint32_t qt = r.trial(d, k - 1, m);
-        big_integer dq = d * qt;
-        dq.data_.resize(dq.data_.size() + m + 1, 0);
-        if (r.smaller(dq, k - 1, m)) {
+        uint32_t qt = trial(r.data(), d.data(), k - 1, m);
+        dq[m] = mul_by_short(dq.data(), d.data(), m, qt);
+        if (smaller(r.data(), dq.data(), k - 1, m)) {
             --qt;
-            dq = big_integer(d) * qt;
+            dq[m] = mul_by_short(dq.data(), d.data(), m, qt);
         }
-        q.data_[k - 1] = qt;
-        r.difference(dq, k - 1, m);
+        q[k - 1] = qt;
+        difference(r.data(), dq.data(), k - 1, m);
+    }
+    if (remainder) {
+        // r holds f * remainder, which divides back exactly
+        divisor_1(f).divrem(r.data(), r.data(), m);
+        data_.resize(m);
+        std::copy(r.data(), r.data() + m, data_.data());
+    } else {
+        data_.resize(n - m + 1);
+        std::copy(q.data(), q.data() + n - m + 1, data_.data());
+    }
+}
+
+big_integer& big_integer::operator/=(big_integer const& rhs) {
+    if (compare_abs(*this, rhs) < 0) {
+        *this = 0;
+        return *this;
+    }
+    bool res_sign = sign ^ rhs.sign;
+    if (rhs.data_.size() == 1) {
+        divrem_small(rhs.data_[0]);
+    } else {
+        long_divide(rhs, false);
     }
-    q.remove_zeros();
-    *this = q;
+    sign = res_sign;
+    remove_zeros();
     return *this;
 }
 
 big_integer& big_integer::operator%=(big_integer const& rhs) {
-    *this = *this - (*this / rhs) * rhs;
+    if (compare_abs(*this, rhs) < 0) {
+        return *this;
+    }
+    if (rhs.data_.size() == 1) {
+        set_small(divrem_small(rhs.data_[0]), sign);
+        return *this;
+    }
+    long_divide(rhs, true);
+    remove_zeros();
     return *this;
 }
 
+namespace {
+// b^-1 mod 2^32 for odd b, by Newton iteration (b itself is correct to 3 bits)
+uint32_t inverse_mod_base(uint32_t b) {
+    uint32_t x = b;
+    for (size_t i = 0; i < 4; ++i) {
+        x *= 2 - b * x;
+    }
+    return x;
+}
+
+// copies a >> bits into res, returns the number of limbs without leading zeros
+size_t shifted_copy(uint32_t *res, uint32_t const *a, size_t n, size_t bits) {
+    size_t words = bits / 32, t = bits % 32;
+    for (size_t i = words; i < n; ++i) {
+        uint32_t next = i + 1 < n ? a[i + 1] : 0;
+        res[i - words] = t ? (a[i] >> t) | (next << (32 - t)) : a[i];
+    }
+    size_t size = n - words;
+    while (size > 1 && res[size - 1] == 0) {
+        --size;
+    }
+    return size;
+}
+
+void divexact_by_short(uint32_t *q, uint32_t const *a, size_t n, uint32_t d) {
+    uint32_t inverse = inverse_mod_base(d);
+    uint32_t c = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t borrow = a[i] < c;
+        uint32_t l = (a[i] - c) * inverse;
+        q[i] = l;
+        c = overflow(static_cast<uint64_t>(l) * d) + borrow;
+    }
+}
+
+// Hensel division from the low end: only the low qn limbs of r are ever needed.
+void divexact_long(uint32_t *q, uint32_t *r, size_t qn, uint32_t const *d, size_t dn) {
+    uint32_t inverse = inverse_mod_base(d[0]);
+    for (size_t i = 0; i < qn; ++i) {
+        uint32_t qi = r[i] * inverse;
+        q[i] = qi;
+        size_t end = std::min(dn, qn - i);
+        uint32_t borrow = 0;
+        for (size_t j = 0; j < end; ++j) {
+            uint64_t sub = static_cast<uint64_t>(qi) * d[j] + borrow;
+            uint32_t lo = sub;
+            borrow = overflow(sub) + (r[i + j] < lo);
+            r[i + j] -= lo;
+        }
+        for (size_t j = i + end; j < qn && borrow; ++j) {
+            uint32_t cur = r[j];
+            r[j] = cur - borrow;
+            borrow = cur < borrow;
+        }
+    }
+}
+}
+
+big_integer divexact(big_integer const& a, big_integer const& b) {
+    uint32_t const *y = b.data_.data();
+    size_t bits = 0;
+    while (y[bits / 32] == 0) {
+        bits += 32;
+    }
+    bits += __builtin_ctz(y[bits / 32]);
+    size_t an = a.data_.size(), bn = b.data_.size();
+    if (a.is_zero() || an < bits / 32 + 1) {
+        return 0;
+    }
+    scratch_limbs r(an), d(bn);
+    size_t rn = shifted_copy(r.data(), a.data_.data(), an, bits);
+    size_t dn = shifted_copy(d.data(), y, bn, bits);
+    if (rn < dn) {
+        return 0;
+    }
+    size_t qn = rn - dn + 1;
+    big_integer res;
+    res.data_.resize(qn);
+    if (dn == 1) {
+        divexact_by_short(res.data_.data(), r.data(), qn, d[0]);
+    } else {
+        divexact_long(res.data_.data(), r.data(), qn, d.data(), dn);
+    }
+    res.sign = a.sign ^ b.sign;
+    res.remove_zeros();
+    return res;
+}
+
 big_integer big_integer::operator+() const {
     return *this;
 }
@@ -278,45 +777,48 @@ big_integer big_integer::operator--(int) {
 }
 
 std::string to_string(big_integer const& a) {
-    if (a == ZERO) {
-        return "0";
-    }
-    std::string res;
-    big_integer temp(a);
-    while (temp != ZERO) {
-        std::string t = std::to_string((temp % BASE_STRING).data_[0]);
-        std::reverse(t.begin(), t.end());
-        if (temp.data_.size() > 1) {
-            while (t.size() < STEP) {
-                t.push_back('0');
-            }
+    assert(a.normalized());
+    static divisor_1 const chunk_divisor(BASE_STRING);
+    size_t n = a.data_.size();
+    scratch_limbs temp(n), chunks(n + n / 8 + 2);
+    std::copy(a.data_.data(), a.data_.data() + n, temp.data());
+    size_t count = 0;
+    do {
+        chunks[count++] = chunk_divisor.divrem(temp.data(), temp.data(), n);
+        while (n > 1 && temp[n - 1] == 0) {
+            --n;
         }
-        res += t;
-        temp /= BASE_STRING;
-    }
-    if (a.sign) {
-        res.push_back('-');
+    } while (n > 1 || temp[0] != 0);
+    std::string res = a.sign ? "-" : "";
+    res += std::to_string(chunks[count - 1]);
+    char digits[STEP];
+    for (size_t i = count - 1; i > 0; --i) {
+        uint32_t value = chunks[i - 1];
+        for (size_t j = STEP; j > 0; --j) {
+            digits[j - 1] = '0' + value % 10;
+            value /= 10;
+        }
+        res.append(digits, STEP);
     }
-    std::reverse(res.begin(), res.end());
     return res;
 }
 
+// Sets the size to that of the significant limbs in one step and clears the sign of zero.
 void big_integer::remove_zeros() {
-    while (data_.size() > 1 && data_.back() == 0) {
-        data_.pop_back();
-    }
-    if (sign && data_.size() == 1 && data_[0] == 0) {
+    uint32_t const *d = std::as_const(data_).data();
+    size_t n = significant_limbs(d, data_.size());
+    if (n == 1 && d[0] == 0) {
         sign = false;
     }
+    if (n != data_.size()) {
+        data_.resize(n);
+    }
+    assert(normalized());
 }
 
-big_integer big_integer::abs(big_integer a) {
-    a.sign = false;
-    return a;
-}
-
-std::ostream& operator<<(std::ostream& s, big_integer const& a) {
-    return s << to_string(a);
+bool big_integer::normalized() const {
+    size_t n = data_.size();
+    return n > 1 ? data_[n - 1] != 0 : n == 1 && !(sign && data_[0] == 0);
 }
 
 big_integer big_integer::operator~() const {
@@ -324,51 +826,46 @@ big_integer big_integer::operator~() const {
     return r;
 }
 
-void big_integer::to_addition_two() {
-    if (sign) {
-        for (size_t i = 0; i < data_.size(); ++i) {
-            data_[i] = ~data_[i];
-        }
-        --*this;
-    }
-}
-
-big_integer bit_operation(big_integer a, big_integer b, uint32_t func(uint32_t, uint32_t)) {
-    size_t size = std::max(a.data_.size(), b.data_.size());
-    a.data_.resize(size, 0);
-    b.data_.resize(size, 0);
-    a.to_addition_two();
-    b.to_addition_two();
-    big_integer res;
-    res.data_.resize(size);
-    res.sign = func(a.sign, b.sign);
+// Both operands and the result are streamed through two's complement limb by limb:
+// a negative magnitude x is ~x + 1, with the carry kept separately for each of them.
+template <typename Op>
+big_integer& big_integer::bit_operation(big_integer const& rhs, Op op) {
+    size_t n = rhs.data_.size(), size = std::max(data_.size(), n) + 1;
+    uint32_t sa = sign ? UINT32_MAX : 0, sb = rhs.sign ? UINT32_MAX : 0, sr = op(sa, sb);
+    data_.resize(size);
+    uint32_t *r = data_.data();
+    uint32_t const *b = rhs.data_.data();
+    uint32_t ca = sa & 1u, cb = sb & 1u, cr = sr & 1u;
     for (size_t i = 0; i < size; ++i) {
-        res.data_[i] = func(a.data_[i], b.data_[i]);
-    }
-    res.to_addition_two();
-    res.remove_zeros();
-    return res;
+        uint64_t ta = static_cast<uint64_t>(r[i] ^ sa) + ca;
+        uint64_t tb = static_cast<uint64_t>((i < n ? b[i] : 0) ^ sb) + cb;
+        uint64_t tr = static_cast<uint64_t>(op(static_cast<uint32_t>(ta), static_cast<uint32_t>(tb)) ^ sr) + cr;
+        ca = overflow(ta);
+        cb = overflow(tb);
+        cr = overflow(tr);
+        r[i] = tr;
+    }
+    sign = sr;
+    remove_zeros();
+    return *this;
 }
 
 big_integer& big_integer::operator&=(big_integer const& rhs) {
-    *this = bit_operation(*this, rhs, [](uint32_t a, uint32_t b) {
+    return bit_operation(rhs, [](uint32_t a, uint32_t b) {
         return a & b;
     });
-    return *this;
 }
 
 big_integer& big_integer::operator|=(big_integer const& rhs) {
-    *this = bit_operation(*this, rhs, [](uint32_t a, uint32_t b) {
+    return bit_operation(rhs, [](uint32_t a, uint32_t b) {
         return a | b;
     });
-    return *this;
 }
 
 big_integer& big_integer::operator^=(big_integer const& rhs) {
-    *this = bit_operation(*this, rhs, [](uint32_t a, uint32_t b) {
+    return bit_operation(rhs, [](uint32_t a, uint32_t b) {
         return a ^ b;
     });
-    return *this;
 }
 
 big_integer operator&(big_integer a, big_integer const& b) {
@@ -386,76 +883,60 @@ big_integer operator^(big_integer a, big_integer const& b) {
 big_integer& big_integer::operator<<=(int rhs) {
     size_t t = rhs % 32;
     size_t add_zeros = rhs >> 5;
-    data_.resize(data_.size() + add_zeros);
-    for (size_t i = data_.size(); i > add_zeros; --i) {
-        data_[i - 1] = data_[i - 1 - add_zeros];
-    }
-    for (size_t i = 0; i < add_zeros; ++i) {
-        data_[i] = 0;
-    }
-    uint32_t of = 0;
-    for (size_t i = add_zeros; i < data_.size(); ++i) {
-        uint64_t temp = (static_cast<uint64_t>(data_[i]) << t) + of;
-        of = overflow(temp);
-        data_[i] = temp;
-    }
-    if (of) {
-        data_.push_back(of);
+    size_t n = data_.size();
+    data_.resize(n + add_zeros + 1);
+    uint32_t *r = data_.data();
+    std::memmove(r + add_zeros, r, n * sizeof(uint32_t));
+    std::fill(r, r + add_zeros, 0);
+    if (t) {
+        for (size_t i = n + add_zeros; i > add_zeros; --i) {
+            r[i] = (r[i] << t) | (r[i - 1] >> (32 - t));
+        }
+        r[add_zeros] <<= t;
     }
+    remove_zeros();
     return *this;
 }
 
 big_integer& big_integer::operator>>=(int rhs) {
     size_t t = rhs % 32;
     size_t remove_digit = rhs >> 5;
-    for (size_t i = 0; i < (data_.size() - remove_digit); ++i) {
-        data_[i] = data_[i + remove_digit];
-    }
-    for (size_t i = 0; i < remove_digit; ++i) {
-        data_.pop_back();
+    size_t n = data_.size();
+    if (remove_digit >= n) {
+        *this = sign ? -1 : 0;
+        return *this;
     }
-    uint32_t of = 0;
-    for (size_t i = data_.size(); i > 0; --i) {
-        uint64_t temp = static_cast<uint64_t>(data_[i - 1]) << (32 - t);
-        data_[i - 1] = overflow(temp) + of;
-        of = temp;
+    uint32_t const *digits = std::as_const(data_).data();
+    bool lost = t && (digits[remove_digit] & ((1u << t) - 1));
+    for (size_t i = 0; i < remove_digit && !lost; ++i) {
+        lost = digits[i] != 0;
+    }
+    size_t size = n - remove_digit;
+    uint32_t *r = data_.data();
+    std::memmove(r, r + remove_digit, size * sizeof(uint32_t));
+    if (t) {
+        for (size_t i = 0; i + 1 < size; ++i) {
+            r[i] = (r[i] >> t) | (r[i + 1] << (32 - t));
+        }
+        r[size - 1] >>= t;
     }
-    if (sign) {
-        --*this;
+    if (sign && lost) {
+        // rounding towards minus infinity adds one to the magnitude
+        size_t i = 0;
+        while (i < size && ++r[i] == 0) {
+            ++i;
+        }
+        data_.resize(size);
+        if (i == size) {
+            data_.push_back(1);
+        }
+    } else {
+        data_.resize(size);
     }
     remove_zeros();
     return *this;
 }
 
-uint32_t big_integer::trial(big_integer &d, size_t k, size_t m) {
-    size_t km = k + m;
-    uint128 r3 = (data_[km] * BASE + data_[km - 1]) * BASE + data_[km - 2];
-    uint64_t d2 = d.data_[m - 1] * BASE + d.data_[m - 2];
-    return std::min(r3 / d2, BASE - 1);
-}
-
-
-bool big_integer::smaller(big_integer &dq, size_t k, size_t m) {
-    size_t i = m, j = 0;
-    while (i != j) {
-        if (data_[i + k] != dq.data_[i]) {
-            j = i;
-        } else {
-            --i;
-        }
-    }
-    return data_[i + k] < dq.data_[i];
-}
-
-void big_integer::difference(big_integer &dq, size_t k, size_t m) {
-    uint32_t borrow = 0;
-    for (size_t i = 0; i <= m; ++i) {
-        uint64_t diff = BASE + data_[i + k] - dq.data_[i] - borrow;
-        data_[i + k] = diff;
-        borrow = 1 - overflow(diff);
-    }
-}
-
 big_integer operator<<(big_integer a, int b) {
     return a <<= b;
 }
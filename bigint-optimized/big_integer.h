@@ -5,13 +5,67 @@
 #include <vector>
 #include <iosfwd>
 #include <cstdint>
+#include <functional>
+#include <type_traits>
 #include "optimized_vector.h"
+#include "big_integer_parallel.h"
+
+#ifndef BIG_INTEGER_INLINE_LIMBS
+#define BIG_INTEGER_INLINE_LIMBS 8
+#endif
+
+using storage_t = optimized_vector<BIG_INTEGER_INLINE_LIMBS>;
+
+namespace big_integer_detail {
+// at most 64 bits, so that magnitude holds the value; wider types (__int128) are left out
+template <typename T>
+using if_machine_integer =
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= sizeof(uint64_t), int>;
+
+template <typename T>
+constexpr uint64_t magnitude(T a) {
+    if constexpr (std::is_signed_v<T>) {
+        return a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+    } else {
+        return a;
+    }
+}
+
+template <typename T>
+constexpr bool negative(T a) {
+    if constexpr (std::is_signed_v<T>) {
+        return a < 0;
+    } else {
+        return false;
+    }
+}
+}
+
+// Single-limb divisor with a precomputed reciprocal, so dividing by it needs no hardware div.
+struct divisor_1 {
+    explicit divisor_1(uint32_t d);
+
+    uint32_t value() const;
+
+    // q = u / d over n limbs (q may be u itself), returns u % d
+    uint32_t divrem(uint32_t *q, uint32_t const *u, size_t n) const;
+
+private:
+    uint32_t d;
+    uint32_t norm_shift;
+    uint32_t normalized;
+    uint32_t reciprocal;
+
+    uint32_t divrem_2_1(uint32_t &r, uint32_t u1, uint32_t u0) const;
+};
 
 struct big_integer {
     big_integer();
     big_integer(big_integer const& other);
     big_integer(int a);
     big_integer(uint32_t a);
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    big_integer(T a) : big_integer(big_integer_detail::magnitude(a), big_integer_detail::negative(a)) {}
     explicit big_integer(std::string const& str);
     ~big_integer();
 
@@ -30,6 +84,37 @@ struct big_integer {
     big_integer& operator<<=(int rhs);
     big_integer& operator>>=(int rhs);
 
+    // Machine integer operands go through single-limb kernels without building a big_integer.
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    big_integer& operator+=(T rhs) {
+        return add_small(big_integer_detail::magnitude(rhs), big_integer_detail::negative(rhs));
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    big_integer& operator-=(T rhs) {
+        return add_small(big_integer_detail::magnitude(rhs), !big_integer_detail::negative(rhs));
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    big_integer& operator*=(T rhs) {
+        return mul_small(big_integer_detail::magnitude(rhs), big_integer_detail::negative(rhs));
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    big_integer& operator/=(T rhs) {
+        divrem_small(big_integer_detail::magnitude(rhs));
+        sign ^= big_integer_detail::negative(rhs);
+        remove_zeros();
+        return *this;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    big_integer& operator%=(T rhs) {
+        bool negative = sign;
+        set_small(divrem_small(big_integer_detail::magnitude(rhs)), negative);
+        return *this;
+    }
+
     big_integer operator+() const;
     big_integer operator-() const;
     big_integer operator~() const;
@@ -40,6 +125,9 @@ struct big_integer {
     big_integer& operator--();
     big_integer operator--(int);
 
+    // number of significant bits of the magnitude, 0 for zero
+    size_t bit_length() const;
+
     friend bool operator==(big_integer const& a, big_integer const& b);
     friend bool operator!=(big_integer const& a, big_integer const& b);
     friend bool operator<(big_integer const& a, big_integer const& b);
@@ -47,23 +135,173 @@ struct big_integer {
     friend bool operator<=(big_integer const& a, big_integer const& b);
     friend bool operator>=(big_integer const& a, big_integer const& b);
 
+    friend int compare(big_integer const& a, big_integer const& b);
+    friend int compare_abs(big_integer const& a, big_integer const& b);
+
     friend std::string to_string(big_integer const& a);
+    friend uint64_t hash_value(big_integer const& a);
+    friend std::ostream& operator<<(std::ostream& s, big_integer const& a);
+    friend std::istream& operator>>(std::istream& s, big_integer& a);
+    friend big_integer divexact(big_integer const& a, big_integer const& b);
+    friend uint32_t divrem(big_integer& a, divisor_1 const& d);
+    friend big_integer gcd(big_integer const& a, big_integer const& b);
+    friend big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t);
+    friend big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+    friend bool is_probable_prime(big_integer const& a, int rounds);
+    friend big_integer next_prime(big_integer const& a);
+    friend struct big_integer_batch;
+    friend void serialize(big_integer const& a, std::vector<uint8_t>& out);
+    friend big_integer deserialize(uint8_t const *data, size_t size, size_t& offset);
+    friend struct big_integer_view;
+    friend struct big_accumulator;
+    friend struct mod_context;
+    template <size_t Bits, bool Signed>
+    friend struct wide_int;
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator+(big_integer a, T b) {
+        return a += b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator+(T a, big_integer b) {
+        return b += a;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator-(big_integer a, T b) {
+        return a -= b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator-(T a, big_integer b) {
+        b -= a;
+        b.sign = !b.sign && !b.is_zero();
+        return b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator*(big_integer a, T b) {
+        return a *= b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator*(T a, big_integer b) {
+        return b *= a;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator/(big_integer a, T b) {
+        return a /= b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator/(T a, big_integer const& b) {
+        return big_integer(a) /= b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator%(big_integer a, T b) {
+        return a %= b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend big_integer operator%(T a, big_integer const& b) {
+        return big_integer(a) %= b;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend int compare(big_integer const& a, T b) {
+        return compare_small(a, big_integer_detail::magnitude(b), big_integer_detail::negative(b));
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator==(big_integer const& a, T b) {
+        return compare(a, b) == 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator==(T a, big_integer const& b) {
+        return compare(b, a) == 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator!=(big_integer const& a, T b) {
+        return compare(a, b) != 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator!=(T a, big_integer const& b) {
+        return compare(b, a) != 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator<(big_integer const& a, T b) {
+        return compare(a, b) < 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator<(T a, big_integer const& b) {
+        return compare(b, a) > 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator>(big_integer const& a, T b) {
+        return compare(a, b) > 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator>(T a, big_integer const& b) {
+        return compare(b, a) < 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator<=(big_integer const& a, T b) {
+        return compare(a, b) <= 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator<=(T a, big_integer const& b) {
+        return compare(b, a) >= 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator>=(big_integer const& a, T b) {
+        return compare(a, b) >= 0;
+    }
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    friend bool operator>=(T a, big_integer const& b) {
+        return compare(b, a) <= 0;
+    }
 
 private:
     bool sign;
-    optimized_vector data_;
+    storage_t data_;
 
-    uint32_t trial(big_integer &d, size_t k, size_t m);
-    bool smaller(big_integer &dq, size_t k, size_t m);
-    void difference(big_integer &dq, size_t k, size_t m);
-    big_integer& div_by_short(uint32_t a);
-    void remove_zeros();
+    big_integer(uint64_t magnitude, bool negative);
+    big_integer(storage_t::borrowed_limbs limbs, bool negative);
+
+    bool is_zero() const;
+    void set_small(uint64_t magnitude, bool negative);
+    big_integer& add_small(uint64_t magnitude, bool negative);
+    big_integer& mul_small(uint64_t magnitude, bool negative);
+    uint64_t divrem_small(uint64_t d);
+    static int compare_small(big_integer const& a, uint64_t magnitude, bool negative);
 
-    static big_integer abs(big_integer a);
+    // The limbs hold the magnitude, at least one of them and the top one nonzero unless the value
+    // is zero, which is never negative. Operations restore this with remove_zeros before returning;
+    // debug builds assert it where it is relied upon.
+    void remove_zeros();
+    bool normalized() const;
+    void long_divide(big_integer const& rhs, bool remainder);
+    void add_abs(big_integer const& rhs);
+    void sub_abs(big_integer const& rhs, bool reversed);
 
-    friend big_integer bit_operation(big_integer a, big_integer b, uint32_t func(uint32_t, uint32_t));
+    template <typename Op>
+    big_integer& bit_operation(big_integer const& rhs, Op op);
 
-    void to_addition_two();
+    static bool lehmer_step(big_integer& a, big_integer& b, int64_t matrix[4]);
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
@@ -72,6 +310,93 @@ big_integer operator*(big_integer a, big_integer const& b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
 
+// a / b for a known to be a multiple of b; the result is unspecified otherwise
+big_integer divexact(big_integer const& a, big_integer const& b);
+
+// a becomes a / d rounded towards zero, returns |a % d|
+uint32_t divrem(big_integer& a, divisor_1 const& d);
+
+// Non-negative gcd: binary for values up to 64 bits, Lehmer steps above that.
+big_integer gcd(big_integer const& a, big_integer const& b);
+// Also finds s and t with s * a + t * b = gcd(a, b).
+big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t);
+// x in [0, |m|) with a * x = 1 (mod m); throws std::domain_error if there is none
+big_integer invert(big_integer const& a, big_integer const& m);
+
+big_integer pow(big_integer base, uint32_t e);
+// floor of the n-th root (rounded towards zero for negative a and odd n); Newton's method
+// started from the root of the top half of the bits. Throws std::domain_error for n == 0
+// and for even roots of negative numbers.
+big_integer iroot(big_integer const& a, uint32_t n);
+big_integer isqrt(big_integer const& a);
+// whether a = b^k for some integers b and k > 1 (0, 1 and -1 included)
+bool is_perfect_power(big_integer const& a);
+
+// base^exp mod |mod| in [0, |mod|), Montgomery multiplication with a sliding window for odd moduli.
+// A negative exponent inverts base first; throws std::domain_error for a zero modulus or
+// a non-invertible base.
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+// Trial division by the primes below 1000, then BPSW (a strong probable prime test to base 2 and
+// a strong Lucas test) and rounds more Miller-Rabin tests to pseudo-random bases.
+// Numbers below 2, negative ones included, are not prime.
+bool is_probable_prime(big_integer const& a, int rounds = 0);
+// smallest probable prime greater than a
+big_integer next_prime(big_integer const& a);
+
+// Multiplied out on balanced product trees whose large subtrees run on separate threads;
+// factorial goes through the prime factorisation of the swing n! / (n / 2)!^2.
+big_integer factorial(uint64_t n);
+big_integer binomial(uint64_t n, uint64_t k);
+// product of the primes up to n
+big_integer primorial(uint64_t n);
+
+namespace big_integer_detail {
+big_integer product(big_integer const *const *items, size_t n);
+big_integer sum(big_integer const *const *items, size_t n);
+
+// value is the magnitude of a small record and the limb count of the others
+struct serialized_header {
+    bool sign;
+    bool small;
+    uint64_t value;
+    uint8_t const *limbs;
+};
+
+serialized_header read_header(uint8_t const *data, size_t size, size_t& offset);
+
+template <typename It>
+std::vector<big_integer const*> addresses(It first, It last) {
+    std::vector<big_integer const*> res;
+    for (; first != last; ++first) {
+        res.push_back(&*first);
+    }
+    return res;
+}
+}
+
+// Product and sum of the big_integers in [first, last), which must refer to stored values.
+// The product is taken on a balanced tree, and large ranges are split between threads
+// (see set_big_integer_threads) without changing the result.
+template <typename It>
+big_integer product(It first, It last) {
+    std::vector<big_integer const*> items = big_integer_detail::addresses(first, last);
+    return big_integer_detail::product(items.data(), items.size());
+}
+
+template <typename It>
+big_integer sum(It first, It last) {
+    std::vector<big_integer const*> items = big_integer_detail::addresses(first, last);
+    return big_integer_detail::sum(items.data(), items.size());
+}
+
+// Binary records: a varint header with the sign and either the magnitude itself, if it is below 2^62,
+// or the number of limbs, which then follow in little-endian order from the next offset divisible by 4.
+// Offsets count from the start of the buffer, so that the limbs of a 4-aligned buffer can be used in place.
+void serialize(big_integer const& a, std::vector<uint8_t>& out);
+// Reads the record at data + offset and moves offset past it;
+// throws std::invalid_argument for truncated or malformed input.
+big_integer deserialize(uint8_t const *data, size_t size, size_t& offset);
+
 big_integer operator&(big_integer a, big_integer const& b);
 big_integer operator|(big_integer a, big_integer const& b);
 big_integer operator^(big_integer a, big_integer const& b);
@@ -87,7 +412,29 @@ bool operator>(big_integer const& a, big_integer const& b);
 bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
+// -1, 0 or 1 as a is less than, equal to or greater than b (compare_abs looks at magnitudes only)
+int compare(big_integer const& a, big_integer const& b);
+int compare_abs(big_integer const& a, big_integer const& b);
+
 std::string to_string(big_integer const& a);
+// Formatted like the built-in integers: dec, hex and oct, showbase, showpos, uppercase, width, fill
+// and the adjustment. Negative numbers keep a minus sign in every base. Characters go to the stream
+// buffer in small blocks, without building the whole string first.
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
+// Reads an optionally signed number in the base of the stream, or one given by a 0x or 0 prefix if
+// the base flags are cleared; sets failbit, and a to 0, if there are no digits.
+std::istream& operator>>(std::istream& s, big_integer& a);
+
+// Mixes the sign and the limbs 64 bits at a time; equal values hash equally.
+uint64_t hash_value(big_integer const& a);
+
+namespace std {
+template <>
+struct hash<big_integer> {
+    size_t operator()(big_integer const& a) const {
+        return hash_value(a);
+    }
+};
+}
 
 #endif // BIG_INTEGER_H
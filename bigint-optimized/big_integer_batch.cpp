@@ -0,0 +1,160 @@
+#include "big_integer_batch.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+// lanes are processed in blocks of this many, keeping the per-lane carries in a local array
+size_t const BLOCK = 64;
+size_t const MUL_LANES = 32;
+
+void check_shapes(big_integer_batch const& r, big_integer_batch const& a, big_integer_batch const& b) {
+    if (a.lanes() != b.lanes() || a.limbs() != b.limbs() || r.lanes() != a.lanes() || r.limbs() != a.limbs()) {
+        throw std::invalid_argument("big_integer_batch: shapes differ");
+    }
+}
+}
+
+big_integer_batch::big_integer_batch(size_t lanes, size_t limbs) : lanes_(lanes), limbs_(limbs), data_(lanes * limbs) {
+    if (limbs == 0) {
+        throw std::invalid_argument("big_integer_batch: zero width");
+    }
+}
+
+size_t big_integer_batch::lanes() const {
+    return lanes_;
+}
+
+size_t big_integer_batch::limbs() const {
+    return limbs_;
+}
+
+uint32_t* big_integer_batch::limb(size_t i) {
+    return data_.data() + i * lanes_;
+}
+
+uint32_t const* big_integer_batch::limb(size_t i) const {
+    return data_.data() + i * lanes_;
+}
+
+void big_integer_batch::set(size_t lane, big_integer const& value) {
+    uint32_t const *m = value.data_.data();
+    size_t n = value.data_.size();
+    uint64_t carry = 1;
+    for (size_t i = 0; i < limbs_; ++i) {
+        uint32_t x = i < n ? m[i] : 0;
+        if (value.sign) {
+            carry += static_cast<uint32_t>(~x);
+            x = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        limb(i)[lane] = x;
+    }
+}
+
+big_integer big_integer_batch::get(size_t lane) const {
+    big_integer res;
+    res.sign = limb(limbs_ - 1)[lane] >> 31u;
+    res.data_.resize(limbs_);
+    uint32_t *r = res.data_.data();
+    uint64_t carry = 1;
+    for (size_t i = 0; i < limbs_; ++i) {
+        uint32_t x = limb(i)[lane];
+        if (res.sign) {
+            carry += static_cast<uint32_t>(~x);
+            x = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        r[i] = x;
+    }
+    res.remove_zeros();
+    return res;
+}
+
+void add(big_integer_batch& r, big_integer_batch const& a, big_integer_batch const& b) {
+    check_shapes(r, a, b);
+    for (size_t first = 0; first < a.lanes(); first += BLOCK) {
+        size_t w = std::min(BLOCK, a.lanes() - first);
+        // carries stay 32 bits wide so that a vector holds as many of them as of limbs
+        uint32_t carry[BLOCK] = {};
+        for (size_t i = 0; i < a.limbs(); ++i) {
+            uint32_t const *x = a.limb(i) + first, *y = b.limb(i) + first;
+            uint32_t *z = r.limb(i) + first;
+            for (size_t j = 0; j < w; ++j) {
+                uint32_t s = x[j] + y[j], t = s + carry[j];
+                carry[j] = (s < x[j]) | (t < s);
+                z[j] = t;
+            }
+        }
+    }
+}
+
+void sub(big_integer_batch& r, big_integer_batch const& a, big_integer_batch const& b) {
+    check_shapes(r, a, b);
+    for (size_t first = 0; first < a.lanes(); first += BLOCK) {
+        size_t w = std::min(BLOCK, a.lanes() - first);
+        uint32_t borrow[BLOCK] = {};
+        for (size_t i = 0; i < a.limbs(); ++i) {
+            uint32_t const *x = a.limb(i) + first, *y = b.limb(i) + first;
+            uint32_t *z = r.limb(i) + first;
+            for (size_t j = 0; j < w; ++j) {
+                uint32_t d = x[j] - y[j], t = d - borrow[j];
+                borrow[j] = (x[j] < y[j]) | (d < borrow[j]);
+                z[j] = t;
+            }
+        }
+    }
+}
+
+void mul(big_integer_batch& r, big_integer_batch const& a, big_integer_batch const& b) {
+    check_shapes(r, a, b);
+    size_t limbs = a.limbs();
+    // Operands and product of MUL_LANES lanes are gathered here, so that the carries of a row
+    // stay in registers and r may be one of the operands.
+    std::vector<uint32_t> x(limbs * MUL_LANES), y(limbs * MUL_LANES), acc(limbs * MUL_LANES);
+    for (size_t first = 0; first < a.lanes(); first += MUL_LANES) {
+        size_t w = std::min(MUL_LANES, a.lanes() - first);
+        for (size_t i = 0; i < limbs; ++i) {
+            std::copy(a.limb(i) + first, a.limb(i) + first + w, x.data() + i * MUL_LANES);
+            std::copy(b.limb(i) + first, b.limb(i) + first + w, y.data() + i * MUL_LANES);
+        }
+        std::fill(acc.begin(), acc.end(), 0);
+        for (size_t i = 0; i < limbs; ++i) {
+            uint32_t const *xi = x.data() + i * MUL_LANES;
+            uint64_t carry[MUL_LANES] = {};
+            for (size_t j = 0; i + j < limbs; ++j) {
+                uint32_t const *yj = y.data() + j * MUL_LANES;
+                uint32_t *t = acc.data() + (i + j) * MUL_LANES;
+                for (size_t k = 0; k < MUL_LANES; ++k) {
+                    uint64_t s = t[k] + static_cast<uint64_t>(xi[k]) * yj[k] + carry[k];
+                    t[k] = static_cast<uint32_t>(s);
+                    carry[k] = s >> 32u;
+                }
+            }
+        }
+        for (size_t i = 0; i < limbs; ++i) {
+            std::copy(acc.data() + i * MUL_LANES, acc.data() + i * MUL_LANES + w, r.limb(i) + first);
+        }
+    }
+}
+
+void compare(int8_t* r, big_integer_batch const& a, big_integer_batch const& b) {
+    check_shapes(a, a, b);
+    for (size_t first = 0; first < a.lanes(); first += BLOCK) {
+        size_t w = std::min(BLOCK, a.lanes() - first);
+        // kept as wide as a limb until the end, so that the loop runs on full vectors
+        int32_t res[BLOCK] = {};
+        for (size_t i = 0; i < a.limbs(); ++i) {
+            // flipping the sign bit of the top limb turns the signed comparison into an unsigned one
+            uint32_t flip = i + 1 == a.limbs() ? 1u << 31u : 0;
+            uint32_t const *x = a.limb(i) + first, *y = b.limb(i) + first;
+            for (size_t j = 0; j < w; ++j) {
+                uint32_t u = x[j] ^ flip, v = y[j] ^ flip;
+                res[j] = u == v ? res[j] : (u > v) - (u < v);
+            }
+        }
+        for (size_t j = 0; j < w; ++j) {
+            r[first + j] = static_cast<int8_t>(res[j]);
+        }
+    }
+}
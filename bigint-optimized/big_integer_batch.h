@@ -0,0 +1,39 @@
+#ifndef BIG_INTEGER_BATCH_H
+#define BIG_INTEGER_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "big_integer.h"
+
+// lanes numbers of limbs * 32 bits each, in two's complement and stored limb by limb:
+// limb i of every lane is contiguous, so the kernels below step through all lanes at once
+// and the inner loops map onto vector registers. Arithmetic wraps around like fixed-width integers.
+struct big_integer_batch {
+    big_integer_batch(size_t lanes, size_t limbs);
+
+    size_t lanes() const;
+    size_t limbs() const;
+
+    // value is reduced modulo 2^(32 * limbs)
+    void set(size_t lane, big_integer const& value);
+    big_integer get(size_t lane) const;
+
+    uint32_t* limb(size_t i);
+    uint32_t const* limb(size_t i) const;
+
+private:
+    size_t lanes_;
+    size_t limbs_;
+    std::vector<uint32_t> data_;
+};
+
+// Lane-wise r = a + b, a - b and a * b (the low limbs of the product); r may be a or b.
+// All three batches need the same shape, std::invalid_argument is thrown otherwise.
+void add(big_integer_batch& r, big_integer_batch const& a, big_integer_batch const& b);
+void sub(big_integer_batch& r, big_integer_batch const& a, big_integer_batch const& b);
+void mul(big_integer_batch& r, big_integer_batch const& a, big_integer_batch const& b);
+// r[lane] is -1, 0 or 1 as lane of a is less than, equal to or greater than that of b
+void compare(int8_t* r, big_integer_batch const& a, big_integer_batch const& b);
+
+#endif // BIG_INTEGER_BATCH_H
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "big_integer.h"
+#include "big_integer_batch.h"
+
+namespace {
+size_t const number_of_operands = 64;
+size_t const number_of_rounds = 2000;
+size_t const widths[] = {32, 64, 96, 128, 192, 256, 320, 384, 512, 768, 1024};
+size_t const scaling_widths[] = {size_t(1) << 17u, size_t(1) << 20u};
+size_t const batch_lanes = 1u << 8u;
+size_t const batch_rounds = 1000;
+
+volatile size_t sink = 0;
+
+big_integer random_of_width(size_t bits, std::mt19937& rng) {
+    big_integer result = 1;
+    for (size_t done = 1; done < bits;) {
+        size_t chunk = std::min<size_t>(31, bits - done);
+        result <<= static_cast<int>(chunk);
+        result += big_integer(static_cast<uint32_t>(rng() & ((1u << chunk) - 1)));
+        done += chunk;
+    }
+    return result;
+}
+
+template <typename F>
+double measure(std::vector<big_integer> const& a, std::vector<big_integer> const& b, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < number_of_rounds; ++round) {
+        for (size_t i = 0; i < a.size(); ++i) {
+            sink += f(a[i], b[i]);
+        }
+    }
+    auto finish = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(finish - start).count();
+    return ns / (number_of_rounds * a.size());
+}
+
+// Time of one multiplication of two bits-wide numbers for each thread count up to the hardware's.
+void mul_scaling(std::mt19937& rng) {
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    unsigned saved = get_big_integer_threads();
+    std::printf("\nmultiplication scaling (%u hardware threads)\n%10s %8s %10s %8s\n", hardware, "bits", "threads", "ms", "speedup");
+    for (size_t bits : scaling_widths) {
+        big_integer a = random_of_width(bits, rng), b = random_of_width(bits, rng);
+        big_integer expected;
+        double single = 0;
+        for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+            set_big_integer_threads(threads);
+            auto start = std::chrono::steady_clock::now();
+            big_integer c = a * b;
+            auto finish = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(finish - start).count();
+            if (threads == 1) {
+                expected = c;
+                single = ms;
+            } else if (c != expected) {
+                std::printf("result differs with %u threads\n", threads);
+            }
+            std::printf("%10zu %8u %10.1f %8.2f\n", bits, threads, ms, single / ms);
+        }
+    }
+    set_big_integer_threads(saved);
+}
+
+template <typename F>
+double per_lane(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < batch_rounds; ++round) {
+        f();
+    }
+    auto finish = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(finish - start).count() / (batch_rounds * batch_lanes);
+}
+
+// Same operations on the same values, one big_integer at a time and lane-wise over a batch.
+void batch_throughput(std::mt19937& rng) {
+    std::printf("\nbatch of %zu lanes, ns per lane\n%8s %10s %10s %10s %10s %10s %10s\n", batch_lanes,
+                "bits", "add", "batch add", "mul", "batch mul", "cmp", "batch cmp");
+    for (size_t bits : {size_t(256), size_t(512)}) {
+        size_t limbs = bits / 32;
+        std::vector<big_integer> a, b, c(batch_lanes);
+        big_integer_batch x(batch_lanes, limbs), y(batch_lanes, limbs), z(batch_lanes, limbs);
+        for (size_t i = 0; i < batch_lanes; ++i) {
+            a.push_back(random_of_width(bits / 2 - 1, rng));
+            b.push_back(random_of_width(bits / 2 - 1, rng));
+            x.set(i, a[i]);
+            y.set(i, b[i]);
+        }
+        std::vector<int8_t> order(batch_lanes);
+        double add_scalar = per_lane([&] {
+            for (size_t i = 0; i < batch_lanes; ++i) {
+                c[i] = a[i] + b[i];
+            }
+        });
+        double add_batch = per_lane([&] {
+            add(z, x, y);
+        });
+        double mul_scalar = per_lane([&] {
+            for (size_t i = 0; i < batch_lanes; ++i) {
+                c[i] = a[i] * b[i];
+            }
+        });
+        double mul_batch = per_lane([&] {
+            mul(z, x, y);
+        });
+        double cmp_scalar = per_lane([&] {
+            for (size_t i = 0; i < batch_lanes; ++i) {
+                order[i] = static_cast<int8_t>(compare(a[i], b[i]));
+            }
+        });
+        double cmp_batch = per_lane([&] {
+            compare(order.data(), x, y);
+        });
+        sink += order[0] + c[0].bit_length() + z.get(0).bit_length();
+        std::printf("%8zu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", bits, add_scalar, add_batch, mul_scalar, mul_batch,
+                    cmp_scalar, cmp_batch);
+    }
+}
+}
+
+int main() {
+    std::mt19937 rng(42);
+    size_t const inline_bits = BIG_INTEGER_INLINE_LIMBS * 32;
+    std::printf("inline limbs: %d (values up to %zu bits stay off the heap)\n", BIG_INTEGER_INLINE_LIMBS, inline_bits);
+    std::printf("%8s %6s %10s %10s %10s %10s\n", "bits", "heap", "copy ns", "add ns", "mul ns", "div ns");
+    for (size_t bits : widths) {
+        std::vector<big_integer> a, b, c;
+        for (size_t i = 0; i < number_of_operands; ++i) {
+            a.push_back(random_of_width(bits, rng));
+            b.push_back(random_of_width(bits, rng));
+            c.push_back(random_of_width(bits / 2 + 1, rng));
+        }
+        double copy = measure(a, b, [](big_integer const& x, big_integer const&) {
+            big_integer y = x;
+            y += 1;
+            return y != x;
+        });
+        double add = measure(a, b, [](big_integer const& x, big_integer const& y) {
+            return (x + y) != x;
+        });
+        double mul = measure(a, b, [](big_integer const& x, big_integer const& y) {
+            return (x * y) != x;
+        });
+        double div = measure(a, c, [](big_integer const& x, big_integer const& y) {
+            return (x / y) != x;
+        });
+        bool heap = bits > inline_bits;
+        std::printf("%8zu %6s %10.1f %10.1f %10.1f %10.1f\n", bits, heap ? "yes" : "no", copy, add, mul, div);
+    }
+    mul_scaling(rng);
+    batch_throughput(rng);
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include "big_integer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// subtrees of at most LEAF_FACTORS factors are multiplied out in a row,
+// only those of at least PARALLEL_LIMBS limbs in total are worth a thread
+size_t const LEAF_FACTORS = 16;
+size_t const PARALLEL_LIMBS = 2048;
+
+// Appends f, merging it into the last word while the product still fits into 64 bits.
+void push_factor(std::vector<uint64_t>& words, uint64_t f) {
+    if (!words.empty() && words.back() <= UINT64_MAX / f) {
+        words.back() *= f;
+    } else {
+        words.push_back(f);
+    }
+}
+
+uint64_t factor(uint64_t f) {
+    return f;
+}
+
+big_integer const& factor(big_integer const *f) {
+    return *f;
+}
+
+size_t limbs(uint64_t) {
+    return 2;
+}
+
+size_t limbs(big_integer const *f) {
+    return f->bit_length() / 32 + 1;
+}
+
+template <typename T>
+size_t total_limbs(T const *f, size_t n) {
+    size_t res = 0;
+    for (size_t i = 0; i < n; ++i) {
+        res += limbs(f[i]);
+    }
+    return res;
+}
+
+// Both halves of every multiplication are of about the same size, which keeps the total work
+// close to that of the last multiplication instead of growing with the square of the count.
+template <typename T>
+big_integer product_tree(T const *f, size_t n, size_t size, unsigned threads) {
+    // a single factor is multiplied into a new value rather than copied: the copy would share its
+    // buffer, and the count of a buffer shared by several factors must not change on other threads
+    if (n == 1 || (n <= LEAF_FACTORS && size < PARALLEL_LIMBS)) {
+        big_integer res = 1;
+        for (size_t i = 0; i < n; ++i) {
+            res *= factor(f[i]);
+        }
+        return res;
+    }
+    size_t mid = n / 2, left_size = total_limbs(f, mid);
+    bool parallel = threads > 1 && size >= PARALLEL_LIMBS;
+    unsigned forked = parallel ? threads / 2 : threads;
+    big_integer left, right;
+    big_integer_detail::fork_join(parallel, [&] {
+        left = product_tree(f, mid, left_size, forked);
+    }, [&] {
+        right = product_tree(f + mid, n - mid, size - left_size, parallel ? threads - forked : threads);
+    });
+    return left *= right;
+}
+
+template <typename T>
+big_integer product_of(T const *f, size_t n) {
+    return product_tree(f, n, total_limbs(f, n), get_big_integer_threads());
+}
+
+big_integer product_of(std::vector<uint64_t> const& f) {
+    return product_of(f.data(), f.size());
+}
+
+// Sums grow by a carry at most, so a running += is already linear; the range is only split
+// to hand its parts to other threads.
+big_integer sum_tree(big_integer const *const *items, size_t n, size_t size, unsigned threads) {
+    if (threads < 2 || size < 2 * PARALLEL_LIMBS || n < 2) {
+        big_integer res = 0;
+        for (size_t i = 0; i < n; ++i) {
+            res += *items[i];
+        }
+        return res;
+    }
+    size_t mid = n / 2, left_size = total_limbs(items, mid);
+    unsigned forked = threads / 2;
+    big_integer left, right;
+    big_integer_detail::fork_join(true, [&] {
+        left = sum_tree(items, mid, left_size, forked);
+    }, [&] {
+        right = sum_tree(items + mid, n - mid, size - left_size, threads - forked);
+    });
+    return left += right;
+}
+
+std::vector<uint64_t> primes_up_to(uint64_t n) {
+    std::vector<uint64_t> res;
+    std::vector<bool> composite(n + 1);
+    for (uint64_t i = 2; i <= n; ++i) {
+        if (!composite[i]) {
+            res.push_back(i);
+            for (uint64_t j = i * i; j <= n; j += i) {
+                composite[j] = true;
+            }
+        }
+    }
+    return res;
+}
+
+// n! without its factors of two: the odd part of (n / 2)!^2 times the odd part of the swing
+// n! / (n / 2)!^2, in which every prime p appears to the power sum of floor(n / p^i) mod 2.
+big_integer odd_factorial(uint64_t n, std::vector<uint64_t> const& primes) {
+    if (n < 3) {
+        return 1;
+    }
+    big_integer res = odd_factorial(n / 2, primes);
+    res *= res;
+    std::vector<uint64_t> swing;
+    for (size_t i = 1; i < primes.size() && primes[i] <= n; ++i) {
+        uint64_t p = primes[i];
+        for (uint64_t q = n / p; q > 0; q /= p) {
+            if (q & 1u) {
+                push_factor(swing, p);
+            }
+        }
+    }
+    return res *= product_of(swing);
+}
+}
+
+big_integer big_integer_detail::product(big_integer const *const *items, size_t n) {
+    return product_of(items, n);
+}
+
+big_integer big_integer_detail::sum(big_integer const *const *items, size_t n) {
+    return sum_tree(items, n, total_limbs(items, n), get_big_integer_threads());
+}
+
+big_integer factorial(uint64_t n) {
+    std::vector<uint64_t> const primes = primes_up_to(n);
+    return odd_factorial(n, primes) << static_cast<int>(n - __builtin_popcountll(n));
+}
+
+big_integer binomial(uint64_t n, uint64_t k) {
+    if (k > n) {
+        return 0;
+    }
+    k = std::min(k, n - k);
+    std::vector<uint64_t> f;
+    if (k <= 32 || k < n / 64) {
+        // few factors: sieving up to n would cost more than dividing the falling factorial by k!
+        for (uint64_t i = 0; i < k; ++i) {
+            push_factor(f, n - i);
+        }
+        return divexact(product_of(f), factorial(k));
+    }
+    // Legendre: p appears sum of floor(n / p^i) - floor(k / p^i) - floor((n - k) / p^i) times
+    for (uint64_t p : primes_up_to(n)) {
+        uint64_t a = n, b = k, c = n - k;
+        while (a >= p) {
+            a /= p;
+            b /= p;
+            c /= p;
+            for (uint64_t e = a - b - c; e > 0; --e) {
+                push_factor(f, p);
+            }
+        }
+    }
+    return product_of(f);
+}
+
+big_integer primorial(uint64_t n) {
+    std::vector<uint64_t> f;
+    for (uint64_t p : primes_up_to(n)) {
+        push_factor(f, p);
+    }
+    return product_of(f);
+}
@@ -0,0 +1,161 @@
+#include "big_integer.h"
+
+#include <stdexcept>
+#include <utility>
+
+__extension__ typedef __int128 int128;
+__extension__ typedef unsigned __int128 uint128;
+
+namespace {
+// cofactors are kept below this so that one combine step never overflows its 128-bit carry
+int64_t const COFACTOR_LIMIT = int64_t(1) << 31;
+
+uint64_t binary_gcd(uint64_t a, uint64_t b) {
+    if (a == 0 || b == 0) {
+        return a | b;
+    }
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    while (b != 0) {
+        b >>= __builtin_ctzll(b);
+        if (a > b) {
+            std::swap(a, b);
+        }
+        b -= a;
+    }
+    return a << shift;
+}
+
+// bits [k, k + 62) of the n-limb number p
+int64_t leading_bits(uint32_t const *p, size_t n, size_t k) {
+    size_t word = k / 32;
+    uint128 window = 0;
+    for (size_t i = 3; i > 0; --i) {
+        window <<= 32u;
+        window |= word + i - 1 < n ? p[word + i - 1] : 0;
+    }
+    return static_cast<int64_t>((window >> (k % 32)) & ((uint64_t(1) << 62u) - 1));
+}
+
+int128 magnitude(int128 a) {
+    return a < 0 ? -a : a;
+}
+}
+
+// One step of Lehmer's algorithm (Knuth, Algorithm L) on the leading 62 bits of a >= b > 0.
+// Runs Euclid on the leading parts while the quotients provably match those of a and b,
+// then applies the accumulated matrix to both numbers in one pass. Returns false if
+// not even a single quotient was certain; the caller then has to divide.
+bool big_integer::lehmer_step(big_integer& a, big_integer& b, int64_t matrix[4]) {
+    size_t bits = a.bit_length();
+    size_t k = bits > 62 ? bits - 62 : 0;
+    int64_t x = leading_bits(a.data_.data(), a.data_.size(), k);
+    int64_t y = leading_bits(b.data_.data(), b.data_.size(), k);
+    int64_t A = 1, B = 0, C = 0, D = 1;
+    while (y + C > 0 && y + D > 0) {
+        int64_t q = (x + A) / (y + C);
+        if (q != (x + B) / (y + D)) {
+            break;
+        }
+        int128 next_c = A - static_cast<int128>(q) * C, next_d = B - static_cast<int128>(q) * D;
+        if (magnitude(next_c) >= COFACTOR_LIMIT || magnitude(next_d) >= COFACTOR_LIMIT) {
+            break;
+        }
+        A = C;
+        C = next_c;
+        B = D;
+        D = next_d;
+        int64_t t = x - q * y;
+        x = y;
+        y = t;
+    }
+    if (B == 0) {
+        return false;
+    }
+    size_t n = a.data_.size();
+    b.data_.resize(n);
+    uint32_t *u = a.data_.data(), *v = b.data_.data();
+    int128 carry_u = 0, carry_v = 0;
+    for (size_t i = 0; i < n; ++i) {
+        carry_u += static_cast<int128>(A) * u[i] + static_cast<int128>(B) * v[i];
+        carry_v += static_cast<int128>(C) * u[i] + static_cast<int128>(D) * v[i];
+        u[i] = static_cast<uint32_t>(carry_u);
+        v[i] = static_cast<uint32_t>(carry_v);
+        carry_u >>= 32;
+        carry_v >>= 32;
+    }
+    a.remove_zeros();
+    b.remove_zeros();
+    matrix[0] = A;
+    matrix[1] = B;
+    matrix[2] = C;
+    matrix[3] = D;
+    return true;
+}
+
+big_integer gcd(big_integer const& a, big_integer const& b) {
+    big_integer x = a, y = b;
+    x.sign = y.sign = false;
+    if (x < y) {
+        std::swap(x, y);
+    }
+    int64_t matrix[4];
+    while (y.data_.size() > 2) {
+        if (!big_integer::lehmer_step(x, y, matrix)) {
+            x %= y;
+            std::swap(x, y);
+        }
+    }
+    if (y.is_zero()) {
+        return x;
+    }
+    uint64_t small = y.data_.size() == 2 ? static_cast<uint64_t>(y.data_[1]) << 32u | y.data_[0] : y.data_[0];
+    return big_integer(binary_gcd(small, x.divrem_small(small)));
+}
+
+big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t) {
+    big_integer x = a, y = b;
+    x.sign = y.sign = false;
+    bool swapped = x < y;
+    if (swapped) {
+        std::swap(x, y);
+    }
+    big_integer const &first = swapped ? b : a, &second = swapped ? a : b;
+    // x = s0 * |first| + ... and y = s1 * |first| + ...; the other cofactor is recovered at the end
+    big_integer s0 = 1, s1 = 0;
+    int64_t matrix[4];
+    while (!y.is_zero()) {
+        if (y.data_.size() > 2 && big_integer::lehmer_step(x, y, matrix)) {
+            big_integer next = s0 * matrix[2] + s1 * matrix[3];
+            s0 *= matrix[0];
+            s0 += s1 * matrix[1];
+            s1 = next;
+        } else {
+            big_integer q = x / y;
+            x -= q * y;
+            std::swap(x, y);
+            s0 -= q * s1;
+            std::swap(s0, s1);
+        }
+    }
+    if (first.sign) {
+        s0 = -s0;
+    }
+    big_integer other = second.is_zero() ? big_integer(0) : divexact(x - s0 * first, second);
+    s = swapped ? other : s0;
+    t = swapped ? s0 : other;
+    return x;
+}
+
+big_integer invert(big_integer const& a, big_integer const& m) {
+    big_integer s, t;
+    big_integer modulus = m < 0 ? -m : m;
+    if (modulus == 0 || gcdext(a, modulus, s, t) != 1) {
+        throw std::domain_error("invert: argument is not invertible modulo m");
+    }
+    s %= modulus;
+    if (s < 0) {
+        s += modulus;
+    }
+    return s;
+}
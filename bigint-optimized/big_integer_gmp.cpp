@@ -26,6 +26,24 @@ big_integer_gmp::~big_integer_gmp() {
   mpz_clear(mpz);
 }
 
+big_integer_gmp big_integer_gmp::factorial(unsigned long n) {
+  big_integer_gmp res;
+  mpz_fac_ui(res.mpz, n);
+  return res;
+}
+
+big_integer_gmp big_integer_gmp::binomial(unsigned long n, unsigned long k) {
+  big_integer_gmp res;
+  mpz_bin_uiui(res.mpz, n, k);
+  return res;
+}
+
+big_integer_gmp big_integer_gmp::primorial(unsigned long n) {
+  big_integer_gmp res;
+  mpz_primorial_ui(res.mpz, n);
+  return res;
+}
+
 big_integer_gmp& big_integer_gmp::operator=(big_integer_gmp const& other) {
   mpz_set(mpz, other.mpz);
   return *this;
@@ -183,6 +201,38 @@ bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b) {
   return mpz_cmp(a.mpz, b.mpz) >= 0;
 }
 
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b) {
+  big_integer_gmp res;
+  mpz_gcd(res.mpz, a.mpz, b.mpz);
+  return res;
+}
+
+big_integer_gmp iroot(big_integer_gmp const& a, unsigned long n) {
+  big_integer_gmp res;
+  mpz_root(res.mpz, a.mpz, n);
+  return res;
+}
+
+bool is_perfect_power(big_integer_gmp const& a) {
+  return mpz_perfect_power_p(a.mpz) != 0;
+}
+
+big_integer_gmp powmod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod) {
+  big_integer_gmp res;
+  mpz_powm(res.mpz, base.mpz, exp.mpz, mod.mpz);
+  return res;
+}
+
+bool is_probable_prime(big_integer_gmp const& a, int rounds) {
+  return mpz_probab_prime_p(a.mpz, rounds) != 0;
+}
+
+big_integer_gmp next_prime(big_integer_gmp const& a) {
+  big_integer_gmp res;
+  mpz_nextprime(res.mpz, a.mpz);
+  return res;
+}
+
 std::string to_string(big_integer_gmp const& a) {
   char* tmp = mpz_get_str(NULL, 10, a.mpz);
   std::string res = tmp;
@@ -26,6 +26,10 @@ struct big_integer_gmp {
 
   ~big_integer_gmp();
 
+  static big_integer_gmp factorial(unsigned long n);
+  static big_integer_gmp binomial(unsigned long n, unsigned long k);
+  static big_integer_gmp primorial(unsigned long n);
+
   big_integer_gmp& operator=(big_integer_gmp const& other);
 
   big_integer_gmp& operator+=(big_integer_gmp const& rhs);
@@ -60,6 +64,13 @@ struct big_integer_gmp {
 
   friend std::string to_string(big_integer_gmp const& a);
 
+  friend big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+  friend big_integer_gmp iroot(big_integer_gmp const& a, unsigned long n);
+  friend bool is_perfect_power(big_integer_gmp const& a);
+  friend big_integer_gmp powmod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod);
+  friend bool is_probable_prime(big_integer_gmp const& a, int rounds);
+  friend big_integer_gmp next_prime(big_integer_gmp const& a);
+
  private:
   mpz_t mpz;
 };
@@ -84,6 +95,13 @@ bool operator>(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator<=(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b);
 
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+big_integer_gmp iroot(big_integer_gmp const& a, unsigned long n);
+bool is_perfect_power(big_integer_gmp const& a);
+big_integer_gmp powmod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod);
+bool is_probable_prime(big_integer_gmp const& a, int rounds);
+big_integer_gmp next_prime(big_integer_gmp const& a);
+
 std::string to_string(big_integer_gmp const& a);
 std::ostream& operator<<(std::ostream& s, big_integer_gmp const& a);
 
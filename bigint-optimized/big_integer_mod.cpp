@@ -0,0 +1,417 @@
+#include "big_integer_mod.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+__extension__ typedef unsigned __int128 uint128;
+
+namespace {
+uint64_t inverse_mod_base(uint64_t b) {
+    uint64_t x = b;
+    for (size_t i = 0; i < 5; ++i) {
+        x *= 2 - b * x;
+    }
+    return x;
+}
+
+// r = the low rn words of a * b; r must not alias a or b
+void mul_low(uint64_t *r, size_t rn, uint64_t const *a, size_t an, uint64_t const *b, size_t bn) {
+    std::fill(r, r + rn, 0);
+    for (size_t i = 0; i < an && i < rn; ++i) {
+        uint128 c = 0;
+        size_t j = 0;
+        for (; j < bn && i + j < rn; ++j) {
+            c += r[i + j] + static_cast<uint128>(a[i]) * b[j];
+            r[i + j] = static_cast<uint64_t>(c);
+            c >>= 64u;
+        }
+        if (i + j < rn) {
+            r[i + j] = static_cast<uint64_t>(c);
+        }
+    }
+}
+}
+
+std::vector<uint64_t> big_integer_detail::pack(uint32_t const *limbs, size_t count, size_t words) {
+    std::vector<uint64_t> res(words);
+    for (size_t i = 0; i < count; ++i) {
+        res[i / 2] |= static_cast<uint64_t>(limbs[i]) << (32 * (i % 2));
+    }
+    return res;
+}
+
+bool big_integer_detail::less(uint64_t const *a, uint64_t const *b, size_t n) {
+    for (size_t i = n; i > 0; --i) {
+        if (a[i - 1] != b[i - 1]) {
+            return a[i - 1] < b[i - 1];
+        }
+    }
+    return false;
+}
+
+uint64_t big_integer_detail::add_n(uint64_t *r, uint64_t const *a, uint64_t const *b, size_t n) {
+    uint128 c = 0;
+    for (size_t i = 0; i < n; ++i) {
+        c += static_cast<uint128>(a[i]) + b[i];
+        r[i] = static_cast<uint64_t>(c);
+        c >>= 64u;
+    }
+    return static_cast<uint64_t>(c);
+}
+
+uint64_t big_integer_detail::sub_n(uint64_t *r, uint64_t const *a, uint64_t const *b, size_t n) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint128 d = static_cast<uint128>(a[i]) - b[i] - borrow;
+        r[i] = static_cast<uint64_t>(d);
+        borrow = static_cast<uint64_t>(d >> 127u);
+    }
+    return borrow;
+}
+
+big_integer_detail::montgomery::montgomery(uint32_t const *limbs, size_t count)
+    : n((count + 1) / 2), m(pack(limbs, count, n)), inverse(0 - inverse_mod_base(m[0])), t(n + 2), table() {}
+
+void big_integer_detail::montgomery::mul(uint64_t *r, uint64_t const *a, uint64_t const *b) {
+    uint64_t *p = t.data();
+    for (size_t i = 0; i < n + 2; ++i) {
+        p[i] = 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint128 c = 0;
+        for (size_t j = 0; j < n; ++j) {
+            c += p[j] + static_cast<uint128>(a[j]) * b[i];
+            p[j] = static_cast<uint64_t>(c);
+            c >>= 64u;
+        }
+        c += p[n];
+        p[n] = static_cast<uint64_t>(c);
+        p[n + 1] = static_cast<uint64_t>(c >> 64u);
+        uint64_t u = p[0] * inverse;
+        c = (p[0] + static_cast<uint128>(u) * m[0]) >> 64u;
+        for (size_t j = 1; j < n; ++j) {
+            c += p[j] + static_cast<uint128>(u) * m[j];
+            p[j - 1] = static_cast<uint64_t>(c);
+            c >>= 64u;
+        }
+        c += p[n];
+        p[n - 1] = static_cast<uint64_t>(c);
+        p[n] = p[n + 1] + static_cast<uint64_t>(c >> 64u);
+    }
+    if (p[n] || !less(p, m.data(), n)) {
+        sub_n(p, p, m.data(), n);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = p[i];
+    }
+}
+
+void big_integer_detail::montgomery::add(uint64_t *r, uint64_t const *a, uint64_t const *b) const {
+    if (add_n(r, a, b, n) || !less(r, m.data(), n)) {
+        sub_n(r, r, m.data(), n);
+    }
+}
+
+void big_integer_detail::montgomery::sub(uint64_t *r, uint64_t const *a, uint64_t const *b) const {
+    if (sub_n(r, a, b, n)) {
+        add_n(r, r, m.data(), n);
+    }
+}
+
+void big_integer_detail::montgomery::half(uint64_t *r, uint64_t const *a) const {
+    uint64_t top = 0;
+    if (a[0] & 1u) {
+        top = add_n(r, a, m.data(), n);
+    } else if (r != a) {
+        for (size_t i = 0; i < n; ++i) {
+            r[i] = a[i];
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t next = i + 1 < n ? r[i + 1] : top;
+        r[i] = r[i] >> 1u | next << 63u;
+    }
+}
+
+void big_integer_detail::montgomery::pow(uint64_t *r, uint64_t const *a, uint64_t const *one,
+                                         uint32_t const *e, size_t bits) {
+    size_t k = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+    // table holds a, a^3, a^5, ..., a^(2^k - 1) and then a^2; it only grows, so that repeated
+    // powers with one kernel reuse it
+    size_t entries = size_t(1) << (k - 1);
+    if (table.size() < (entries + 1) * n) {
+        table.resize((entries + 1) * n);
+    }
+    uint64_t *square = table.data() + entries * n;
+    for (size_t i = 0; i < n; ++i) {
+        table[i] = a[i];
+    }
+    if (k > 1) {
+        mul(square, a, a);
+        for (size_t i = 1; i < entries; ++i) {
+            mul(table.data() + i * n, table.data() + (i - 1) * n, square);
+        }
+    }
+    auto bit = [e](size_t i) {
+        return (e[i / 32] >> (i % 32)) & 1u;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = one[i];
+    }
+    bool started = false;
+    for (size_t i = bits; i > 0;) {
+        if (!bit(i - 1)) {
+            mul(r, r, r);
+            --i;
+            continue;
+        }
+        size_t low = i > k ? i - k : 0;
+        while (!bit(low)) {
+            ++low;
+        }
+        size_t w = 0;
+        for (size_t j = i; j > low; --j) {
+            w = w << 1u | bit(j - 1);
+            if (started) {
+                mul(r, r, r);
+            }
+        }
+        uint64_t const *entry = table.data() + (w >> 1u) * n;
+        if (started) {
+            mul(r, r, entry);
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                r[j] = entry[j];
+            }
+            started = true;
+        }
+        i = low;
+    }
+}
+
+mod_context::mod_context(big_integer const& modulus)
+    : modulus_(modulus.sign ? -modulus : modulus), odd_(modulus_.data_[0] & 1u),
+      kernel_(modulus_.data_.data(), modulus_.data_.size()) {
+    if (modulus_.is_zero()) {
+        throw std::domain_error("mod_context: zero modulus");
+    }
+    size_t n = kernel_.n;
+    int shift = static_cast<int>(64 * n);
+    if (odd_) {
+        big_integer const one = (big_integer(1) << shift) % modulus_;
+        big_integer const square = (big_integer(1) << 2 * shift) % modulus_;
+        one_ = big_integer_detail::pack(one.data_.data(), one.data_.size(), n);
+        square_ = big_integer_detail::pack(square.data_.data(), square.data_.size(), n);
+        unit_.assign(n, 0);
+        unit_[0] = 1;
+        scratch_.resize(n);
+    } else {
+        // m >= 2^(64(n - 1)) bounds the factor by 2^(64(n + 1)), which takes n + 2 words
+        big_integer const factor = (big_integer(1) << 2 * shift) / modulus_;
+        one_.assign(n, 0);
+        one_[0] = 1;
+        barrett_ = big_integer_detail::pack(factor.data_.data(), factor.data_.size(), n + 2);
+        // product, its top words times the factor, and the low words of the quotient times m
+        scratch_.resize(n + 2 * n + (2 * n + 3) + (n + 1));
+    }
+}
+
+big_integer const& mod_context::modulus() const {
+    return modulus_;
+}
+
+size_t mod_context::size() const {
+    return kernel_.n;
+}
+
+mod_value mod_context::operator()(big_integer const& x) const {
+    return mod_value(*this, x);
+}
+
+// Barrett: with p = a * b < m^2 and q the top n + 1 words of p times the factor, shifted by
+// n + 1 words, p - q * m is below 3m and fits n + 1 words, so the low words suffice.
+void mod_context::mul(uint64_t *r, uint64_t const *a, uint64_t const *b) const {
+    if (odd_) {
+        kernel_.mul(r, a, b);
+        return;
+    }
+    size_t n = kernel_.n;
+    uint64_t const *m = kernel_.m.data();
+    uint64_t *p = scratch_.data() + n, *q = p + 2 * n, *qm = q + 2 * n + 3;
+    mul_low(p, 2 * n, a, n, b, n);
+    mul_low(q, 2 * n + 3, p + n - 1, n + 1, barrett_.data(), n + 2);
+    mul_low(qm, n + 1, q + n + 1, n + 1, m, n);
+    big_integer_detail::sub_n(p, p, qm, n + 1);
+    while (p[n] || !big_integer_detail::less(p, m, n)) {
+        p[n] -= big_integer_detail::sub_n(p, p, m, n);
+    }
+    std::copy(p, p + n, r);
+}
+
+void mod_context::pow(uint64_t *r, uint64_t const *a, big_integer const& e) const {
+    if (odd_) {
+        kernel_.pow(r, a, one_.data(), e.data_.data(), e.bit_length());
+        return;
+    }
+    uint64_t *base = scratch_.data();
+    std::copy(a, a + kernel_.n, base);
+    std::copy(one_.begin(), one_.end(), r);
+    for (size_t i = e.bit_length(); i > 0; --i) {
+        mul(r, r, r);
+        if ((e.data_[(i - 1) / 32] >> ((i - 1) % 32)) & 1u) {
+            mul(r, r, base);
+        }
+    }
+}
+
+void mod_context::load(uint64_t *r, big_integer const& x) const {
+    big_integer v = x % modulus_;
+    if (v.sign) {
+        v += modulus_;
+    }
+    std::fill(r, r + kernel_.n, 0);
+    for (size_t i = 0; i < v.data_.size(); ++i) {
+        r[i / 2] |= static_cast<uint64_t>(v.data_[i]) << (32 * (i % 2));
+    }
+    if (odd_) {
+        kernel_.mul(r, r, square_.data());
+    }
+}
+
+big_integer mod_context::store(uint64_t const *a) const {
+    size_t n = kernel_.n;
+    uint64_t *words = scratch_.data();
+    if (odd_) {
+        kernel_.mul(words, a, unit_.data());
+    } else {
+        std::copy(a, a + n, words);
+    }
+    big_integer res;
+    res.data_.resize(2 * n);
+    for (size_t i = 0; i < 2 * n; ++i) {
+        res.data_[i] = static_cast<uint32_t>(words[i / 2] >> (32 * (i % 2)));
+    }
+    res.remove_zeros();
+    return res;
+}
+
+mod_value::mod_value(mod_context const& ctx) : ctx_(&ctx) {
+    allocate();
+    std::fill(words_, words_ + size(), 0);
+}
+
+mod_value::mod_value(mod_context const& ctx, big_integer const& x) : ctx_(&ctx) {
+    allocate();
+    ctx.load(words_, x);
+}
+
+mod_value::mod_value(mod_value const& other) : ctx_(other.ctx_) {
+    allocate();
+    std::copy(other.words_, other.words_ + size(), words_);
+}
+
+mod_value::~mod_value() {
+    release();
+}
+
+mod_value& mod_value::operator=(mod_value const& other) {
+    if (size() != other.size()) {
+        release();
+        ctx_ = other.ctx_;
+        allocate();
+    }
+    ctx_ = other.ctx_;
+    std::copy(other.words_, other.words_ + size(), words_);
+    return *this;
+}
+
+size_t mod_value::size() const {
+    return ctx_->size();
+}
+
+void mod_value::allocate() {
+    size_t n = size();
+    if (n <= INLINE_WORDS) {
+        words_ = inline_;
+    } else {
+        words_ = static_cast<uint64_t*>(limb_pool::instance().allocate(n * sizeof(uint64_t), alignof(uint64_t)));
+    }
+}
+
+void mod_value::release() {
+    if (words_ != inline_) {
+        limb_pool::instance().deallocate(words_, size() * sizeof(uint64_t), alignof(uint64_t));
+    }
+}
+
+void mod_value::check(mod_value const& rhs) const {
+    if (ctx_ != rhs.ctx_) {
+        throw std::invalid_argument("mod_value: operands from different contexts");
+    }
+}
+
+mod_value& mod_value::operator+=(mod_value const& rhs) {
+    check(rhs);
+    ctx_->kernel_.add(words_, words_, rhs.words_);
+    return *this;
+}
+
+mod_value& mod_value::operator-=(mod_value const& rhs) {
+    check(rhs);
+    ctx_->kernel_.sub(words_, words_, rhs.words_);
+    return *this;
+}
+
+mod_value& mod_value::operator*=(mod_value const& rhs) {
+    check(rhs);
+    ctx_->mul(words_, words_, rhs.words_);
+    return *this;
+}
+
+mod_value mod_value::operator-() const {
+    mod_value res(*ctx_);
+    ctx_->kernel_.sub(res.words_, res.words_, words_);
+    return res;
+}
+
+mod_value mod_value::inverse() const {
+    return mod_value(*ctx_, invert(value(), ctx_->modulus_));
+}
+
+mod_value mod_value::pow(big_integer const& e) const {
+    if (e < 0) {
+        return inverse().pow(-e);
+    }
+    mod_value res(*ctx_);
+    ctx_->pow(res.words_, words_, e);
+    return res;
+}
+
+big_integer mod_value::value() const {
+    return ctx_->store(words_);
+}
+
+mod_context const& mod_value::context() const {
+    return *ctx_;
+}
+
+bool operator==(mod_value const& a, mod_value const& b) {
+    a.check(b);
+    return std::equal(a.words_, a.words_ + a.size(), b.words_);
+}
+
+bool operator!=(mod_value const& a, mod_value const& b) {
+    return !(a == b);
+}
+
+mod_value operator+(mod_value a, mod_value const& b) {
+    return a += b;
+}
+
+mod_value operator-(mod_value a, mod_value const& b) {
+    return a -= b;
+}
+
+mod_value operator*(mod_value a, mod_value const& b) {
+    return a *= b;
+}
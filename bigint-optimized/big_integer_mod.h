@@ -0,0 +1,123 @@
+#ifndef BIG_INTEGER_MOD_H
+#define BIG_INTEGER_MOD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "big_integer.h"
+
+namespace big_integer_detail {
+// The modular kernels work on 64-bit words, halving the number of inner steps.
+std::vector<uint64_t> pack(uint32_t const *limbs, size_t count, size_t words);
+bool less(uint64_t const *a, uint64_t const *b, size_t n);
+// r = a + b and r = a - b over n words, return the carry or borrow; r may alias a or b
+uint64_t add_n(uint64_t *r, uint64_t const *a, uint64_t const *b, size_t n);
+uint64_t sub_n(uint64_t *r, uint64_t const *a, uint64_t const *b, size_t n);
+
+// Arithmetic modulo an odd m of n words on residues x * 2^(64n) mod m (Montgomery form).
+struct montgomery {
+    montgomery(uint32_t const *limbs, size_t count);
+
+    // r = a * b / 2^(64n) mod m, operand scanning with the reduction interleaved; r may alias a or b
+    void mul(uint64_t *r, uint64_t const *a, uint64_t const *b);
+    void add(uint64_t *r, uint64_t const *a, uint64_t const *b) const;
+    void sub(uint64_t *r, uint64_t const *a, uint64_t const *b) const;
+    // r = a / 2 mod m
+    void half(uint64_t *r, uint64_t const *a) const;
+    // r = a^e for the exponent given by its limbs and bit length, with a sliding window
+    void pow(uint64_t *r, uint64_t const *a, uint64_t const *one, uint32_t const *e, size_t bits);
+
+    size_t n;
+    std::vector<uint64_t> m;
+    uint64_t inverse;
+
+private:
+    // product of mul, and the window table of pow with the square it is built from
+    std::vector<uint64_t> t, table;
+};
+}
+
+struct mod_value;
+
+// Modulus |m| with the constants of its reduction: Montgomery form for odd moduli, Barrett
+// reduction by floor(2^(128n) / m) for even ones. The scratch words of the kernels are allocated
+// here once, so a context and the values over it are for one thread at a time.
+// Throws std::domain_error for a zero modulus.
+struct mod_context {
+    explicit mod_context(big_integer const& modulus);
+
+    mod_context(mod_context const&) = delete;
+    mod_context& operator=(mod_context const&) = delete;
+
+    big_integer const& modulus() const;
+    // words of a residue
+    size_t size() const;
+
+    mod_value operator()(big_integer const& x) const;
+
+private:
+    friend struct mod_value;
+
+    big_integer modulus_;
+    bool odd_;
+    // holds the packed modulus for both reductions, its mul is only used for odd moduli
+    mutable big_integer_detail::montgomery kernel_;
+    // one in the form of the residues, 2^(128n) mod m that takes values into Montgomery form
+    // and 1 that takes them out, and the Barrett factor
+    std::vector<uint64_t> one_, square_, unit_, barrett_;
+    // n words for load, store and pow, then the Barrett products
+    mutable std::vector<uint64_t> scratch_;
+
+    void mul(uint64_t *r, uint64_t const *a, uint64_t const *b) const;
+    void pow(uint64_t *r, uint64_t const *a, big_integer const& e) const;
+    void load(uint64_t *r, big_integer const& x) const;
+    big_integer store(uint64_t const *a) const;
+};
+
+// Residue modulo the modulus of a context, which must outlive it. The words stay in the form of
+// the context between operations. Up to INLINE_WORDS of them are stored in place and larger residues
+// take a block of the limb pool, so arithmetic allocates nothing on the heap once the pool is warm.
+// Operands from different contexts throw std::invalid_argument.
+struct mod_value {
+    static constexpr size_t INLINE_WORDS = 8;
+
+    explicit mod_value(mod_context const& ctx);
+    mod_value(mod_context const& ctx, big_integer const& x);
+    mod_value(mod_value const& other);
+    ~mod_value();
+
+    mod_value& operator=(mod_value const& other);
+
+    mod_value& operator+=(mod_value const& rhs);
+    mod_value& operator-=(mod_value const& rhs);
+    mod_value& operator*=(mod_value const& rhs);
+
+    mod_value operator-() const;
+    // throws std::domain_error if the value is not invertible
+    mod_value inverse() const;
+    // a negative exponent inverts first
+    mod_value pow(big_integer const& e) const;
+
+    // the residue in [0, |m|)
+    big_integer value() const;
+    mod_context const& context() const;
+
+    friend bool operator==(mod_value const& a, mod_value const& b);
+    friend bool operator!=(mod_value const& a, mod_value const& b);
+
+private:
+    mod_context const *ctx_;
+    uint64_t *words_;
+    uint64_t inline_[INLINE_WORDS];
+
+    size_t size() const;
+    void allocate();
+    void release();
+    void check(mod_value const& rhs) const;
+};
+
+mod_value operator+(mod_value a, mod_value const& b);
+mod_value operator-(mod_value a, mod_value const& b);
+mod_value operator*(mod_value a, mod_value const& b);
+
+#endif // BIG_INTEGER_MOD_H
@@ -0,0 +1,36 @@
+#ifndef BIG_INTEGER_PARALLEL_H
+#define BIG_INTEGER_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace big_integer_detail {
+inline std::atomic<unsigned> threads{std::max(1u, std::thread::hardware_concurrency())};
+
+// Runs left and right, the former on a thread of its own when parallel is set.
+template <typename Left, typename Right>
+void fork_join(bool parallel, Left const& left, Right const& right) {
+    if (!parallel) {
+        left();
+        right();
+        return;
+    }
+    std::future<void> pending = std::async(std::launch::async, left);
+    right();
+    pending.get();
+}
+}
+
+// Number of threads the divide and conquer algorithms may spread independent subproblems over,
+// the hardware concurrency by default. Results do not depend on it.
+inline void set_big_integer_threads(unsigned n) {
+    big_integer_detail::threads = std::max(1u, n);
+}
+
+inline unsigned get_big_integer_threads() {
+    return big_integer_detail::threads;
+}
+
+#endif // BIG_INTEGER_PARALLEL_H
@@ -0,0 +1,312 @@
+#include "big_integer.h"
+#include "big_integer_mod.h"
+
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using big_integer_detail::montgomery;
+using big_integer_detail::pack;
+using big_integer_detail::sub_n;
+
+namespace {
+// is_probable_prime divides by the primes below TRIAL_LIMIT, next_prime sieves with all up to SIEVE_LIMIT
+uint32_t const TRIAL_LIMIT = 1000;
+uint32_t const SIEVE_LIMIT = 1u << 15u;
+
+std::vector<uint32_t> const& small_primes() {
+    static std::vector<uint32_t> const primes = [] {
+        std::vector<uint32_t> res;
+        std::vector<bool> composite(SIEVE_LIMIT);
+        for (uint32_t i = 2; i < SIEVE_LIMIT; ++i) {
+            if (!composite[i]) {
+                res.push_back(i);
+                for (uint32_t j = i * i; j < SIEVE_LIMIT; j += i) {
+                    composite[j] = true;
+                }
+            }
+        }
+        return res;
+    }();
+    return primes;
+}
+
+// Consecutive small primes whose product still fits into a limb, so that one division pass
+// over the number serves several of them.
+struct prime_group {
+    divisor_1 product;
+    size_t first, last;
+};
+
+std::vector<prime_group> const& prime_groups() {
+    static std::vector<prime_group> const groups = [] {
+        std::vector<uint32_t> const& primes = small_primes();
+        std::vector<prime_group> res;
+        for (size_t i = 0; i < primes.size();) {
+            uint64_t product = 1;
+            size_t j = i;
+            while (j < primes.size() && product * primes[j] <= UINT32_MAX) {
+                product *= primes[j++];
+            }
+            res.push_back({divisor_1(static_cast<uint32_t>(product)), i, j});
+            i = j;
+        }
+        return res;
+    }();
+    return groups;
+}
+
+// residues[i] = u mod small_primes()[i] for the primes below limit, returns how many there are
+size_t small_residues(uint32_t const *u, size_t n, std::vector<uint32_t>& residues, uint32_t limit) {
+    scratch_limbs q(n);
+    std::vector<uint32_t> const& primes = small_primes();
+    residues.clear();
+    for (prime_group const& group : prime_groups()) {
+        if (primes[group.first] >= limit) {
+            break;
+        }
+        uint32_t r = group.product.divrem(q.data(), u, n);
+        for (size_t i = group.first; i < group.last; ++i) {
+            residues.push_back(r % primes[i]);
+        }
+    }
+    return residues.size();
+}
+
+bool is_zero(std::vector<uint64_t> const& a) {
+    for (uint64_t w : a) {
+        if (w) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int jacobi(uint64_t a, uint64_t n) {
+    int res = 1;
+    a %= n;
+    while (a != 0) {
+        while (a % 2 == 0) {
+            a /= 2;
+            if (n % 8 == 3 || n % 8 == 5) {
+                res = -res;
+            }
+        }
+        std::swap(a, n);
+        if (a % 4 == 3 && n % 4 == 3) {
+            res = -res;
+        }
+        a %= n;
+    }
+    return n == 1 ? res : 0;
+}
+
+size_t trailing_zeros(big_integer const& a) {
+    return (a & -a).bit_length() - 1;
+}
+}
+
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod) {
+    big_integer const m = mod < 0 ? -mod : mod;
+    if (m.is_zero()) {
+        throw std::domain_error("powmod: zero modulus");
+    }
+    big_integer b = exp.sign ? invert(base, m) : base % m;
+    if (b.sign) {
+        b += m;
+    }
+    if (m == 1) {
+        return 0;
+    }
+    size_t bits = exp.bit_length();
+    uint32_t const *e = exp.data_.data();
+    if (!(m.data_[0] & 1u)) {
+        // Montgomery reduction needs an odd modulus
+        big_integer res = 1;
+        for (size_t i = bits; i > 0; --i) {
+            res *= res;
+            res %= m;
+            if ((e[(i - 1) / 32] >> ((i - 1) % 32)) & 1u) {
+                res *= b;
+                res %= m;
+            }
+        }
+        return res;
+    }
+    montgomery mg(m.data_.data(), m.data_.size());
+    size_t n = mg.n;
+    int shift = static_cast<int>(64 * n);
+    big_integer const a = (b << shift) % m, one = (big_integer(1) << shift) % m;
+    std::vector<uint64_t> ma = pack(a.data_.data(), a.data_.size(), n);
+    std::vector<uint64_t> mone = pack(one.data_.data(), one.data_.size(), n);
+    std::vector<uint64_t> r(n), unit(n);
+    unit[0] = 1;
+    mg.pow(r.data(), ma.data(), mone.data(), e, bits);
+    mg.mul(r.data(), r.data(), unit.data());
+    big_integer res;
+    res.data_.resize(2 * n);
+    for (size_t i = 0; i < 2 * n; ++i) {
+        res.data_[i] = static_cast<uint32_t>(r[i / 2] >> (32 * (i % 2)));
+    }
+    res.remove_zeros();
+    return res;
+}
+
+bool is_probable_prime(big_integer const& a, int rounds) {
+    if (a.sign || a < 2) {
+        return false;
+    }
+    std::vector<uint32_t> const& primes = small_primes();
+    std::vector<uint32_t> residues;
+    size_t count = small_residues(a.data_.data(), a.data_.size(), residues, TRIAL_LIMIT);
+    for (size_t i = 0; i < count; ++i) {
+        if (residues[i] == 0 && primes[i] < TRIAL_LIMIT) {
+            return a == primes[i];
+        }
+    }
+    if (a < TRIAL_LIMIT * TRIAL_LIMIT) {
+        return true;
+    }
+
+    montgomery mg(a.data_.data(), a.data_.size());
+    size_t n = mg.n;
+    int shift = static_cast<int>(64 * n);
+    // Montgomery form of a value
+    auto load = [&](big_integer v) {
+        v <<= shift;
+        v %= a;
+        if (v.sign) {
+            v += a;
+        }
+        return pack(v.data_.data(), v.data_.size(), n);
+    };
+    std::vector<uint64_t> const one = load(1);
+    std::vector<uint64_t> minus_one(n), x(n);
+    sub_n(minus_one.data(), mg.m.data(), one.data(), n);
+
+    big_integer const a_minus_1 = a - 1;
+    size_t s = trailing_zeros(a_minus_1);
+    big_integer const d = a_minus_1 >> static_cast<int>(s);
+    // strong probable prime test to the given base
+    auto miller_rabin = [&](std::vector<uint64_t> const& base) {
+        mg.pow(x.data(), base.data(), one.data(), d.data_.data(), d.bit_length());
+        if (x == one || x == minus_one) {
+            return true;
+        }
+        for (size_t r = 1; r < s; ++r) {
+            mg.mul(x.data(), x.data(), x.data());
+            if (x == minus_one) {
+                return true;
+            }
+            if (x == one) {
+                return false;
+            }
+        }
+        return false;
+    };
+
+    if (!miller_rabin(load(2))) {
+        return false;
+    }
+
+    // Selfridge's parameters for the strong Lucas test: the first D in 5, -7, 9, -11, ...
+    // with Jacobi symbol (D / a) = -1, P = 1 and Q = (1 - D) / 4
+    int64_t D = 5;
+    scratch_limbs q(a.data_.size());
+    while (true) {
+        uint64_t magnitude = D < 0 ? -D : D;
+        uint32_t r = divisor_1(static_cast<uint32_t>(magnitude)).divrem(q.data(), a.data_.data(), a.data_.size());
+        int j = jacobi(r, magnitude);
+        if (magnitude % 4 == 3 && a.data_[0] % 4 == 3) {
+            j = -j;
+        }
+        if (D < 0 && a.data_[0] % 4 == 3) {
+            j = -j;
+        }
+        if (j == -1) {
+            break;
+        }
+        if (j == 0) {
+            return false;
+        }
+        // there is no such D for squares
+        if (magnitude == 13 && pow(isqrt(a), 2) == a) {
+            return false;
+        }
+        D = D < 0 ? 2 - D : -D - 2;
+    }
+    std::vector<uint64_t> const md = load(D), mq = load((1 - D) / 4);
+    std::vector<uint64_t> u = one, v = one, qk = mq, t(n);
+    big_integer const a_plus_1 = a + 1;
+    size_t ls = trailing_zeros(a_plus_1);
+    big_integer const ld = a_plus_1 >> static_cast<int>(ls);
+    uint32_t const *e = ld.data_.data();
+    // U_k, V_k and Q^k for the prefixes of the bits of ld, doubling and then stepping k
+    for (size_t i = ld.bit_length() - 1; i > 0; --i) {
+        mg.mul(u.data(), u.data(), v.data());
+        mg.mul(v.data(), v.data(), v.data());
+        mg.sub(v.data(), v.data(), qk.data());
+        mg.sub(v.data(), v.data(), qk.data());
+        mg.mul(qk.data(), qk.data(), qk.data());
+        if ((e[(i - 1) / 32] >> ((i - 1) % 32)) & 1u) {
+            mg.mul(t.data(), md.data(), u.data());
+            mg.add(u.data(), u.data(), v.data());
+            mg.half(u.data(), u.data());
+            mg.add(v.data(), v.data(), t.data());
+            mg.half(v.data(), v.data());
+            mg.mul(qk.data(), qk.data(), mq.data());
+        }
+    }
+    bool lucas = is_zero(u) || is_zero(v);
+    for (size_t r = 1; r < ls && !lucas; ++r) {
+        mg.mul(v.data(), v.data(), v.data());
+        mg.sub(v.data(), v.data(), qk.data());
+        mg.sub(v.data(), v.data(), qk.data());
+        mg.mul(qk.data(), qk.data(), qk.data());
+        lucas = is_zero(v);
+    }
+    if (!lucas) {
+        return false;
+    }
+
+    std::mt19937 rng(a.data_[0]);
+    for (int round = 0; round < rounds; ++round) {
+        big_integer b = 0;
+        for (size_t i = 0; i < a.data_.size(); ++i) {
+            b <<= 32;
+            b += static_cast<uint32_t>(rng());
+        }
+        b %= a - 3;
+        if (!miller_rabin(load(b + 2))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+big_integer next_prime(big_integer const& a) {
+    if (a < 2) {
+        return 2;
+    }
+    big_integer c = a + 1;
+    if (c == 2) {
+        return c;
+    }
+    if (!(c.data_[0] & 1u)) {
+        c += 1;
+    }
+    // candidates with a small factor are sieved out by stepping the residues of c
+    std::vector<uint32_t> const& primes = small_primes();
+    std::vector<uint32_t> residues;
+    size_t count = small_residues(c.data_.data(), c.data_.size(), residues, SIEVE_LIMIT);
+    for (uint64_t offset = 0;; offset += 2) {
+        bool candidate = true;
+        for (size_t i = 0; i < count && candidate; ++i) {
+            candidate = (residues[i] + offset) % primes[i] != 0 || c + offset == primes[i];
+        }
+        if (candidate && is_probable_prime(c + offset)) {
+            return c + offset;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include "big_integer.h"
+
+#include <stdexcept>
+
+big_integer pow(big_integer base, uint32_t e) {
+    big_integer res = 1;
+    while (e) {
+        if (e & 1u) {
+            res *= base;
+        }
+        e >>= 1u;
+        if (e) {
+            base *= base;
+        }
+    }
+    return res;
+}
+
+namespace {
+// Newton's iteration for the n-th root from x > floor(a^(1/n)): it decreases strictly
+// until it reaches the floor of the root.
+big_integer newton_root(big_integer const& a, uint32_t n, big_integer x) {
+    while (true) {
+        big_integer y = x * (n - 1) + a / pow(x, n - 1);
+        y /= n;
+        if (y >= x) {
+            return x;
+        }
+        x = y;
+    }
+}
+
+// floor(a^(1/n)) for a > 0 and n >= 2, doubling the precision on the way back from the top bits
+big_integer root_abs(big_integer const& a, uint32_t n) {
+    size_t bits = a.bit_length();
+    if (bits <= n) {
+        return 1;
+    }
+    if (bits <= 64 || bits < 4 * n) {
+        return newton_root(a, n, big_integer(1) << static_cast<int>((bits + n - 1) / n));
+    }
+    size_t k = bits / (2 * n);
+    big_integer s = root_abs(a >> static_cast<int>(n * k), n) << static_cast<int>(k);
+    // s <= floor(a^(1/n)) < s + 2^k
+    return newton_root(a, n, s + (big_integer(1) << static_cast<int>(k)));
+}
+
+bool is_prime_exponent(uint32_t p) {
+    for (uint32_t d = 2; d * d <= p; ++d) {
+        if (p % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+big_integer iroot(big_integer const& a, uint32_t n) {
+    if (n == 0) {
+        throw std::domain_error("iroot: zeroth root");
+    }
+    if (a < 0) {
+        if (n % 2 == 0) {
+            throw std::domain_error("iroot: even root of a negative number");
+        }
+        return -root_abs(-a, n);
+    }
+    if (a == 0 || n == 1) {
+        return a;
+    }
+    return root_abs(a, n);
+}
+
+big_integer isqrt(big_integer const& a) {
+    return iroot(a, 2);
+}
+
+bool is_perfect_power(big_integer const& a) {
+    big_integer m = a < 0 ? -a : a;
+    if (m <= 1) {
+        return true;
+    }
+    size_t bits = m.bit_length();
+    size_t twos = (m & -m).bit_length() - 1;
+    for (uint32_t p = a < 0 ? 3 : 2; p < bits; ++p) {
+        // the exponent has to divide the number of trailing zero bits
+        if ((twos && twos % p) || !is_prime_exponent(p)) {
+            continue;
+        }
+        if (pow(root_abs(m, p), p) == m) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,101 @@
+#include "big_integer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// The limbs are copied as they lie in memory, which is the documented little-endian order only on
+// little-endian hosts.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "serialize needs a little-endian host");
+
+namespace {
+// values below this go into the header varint itself, next to the sign and the form bit
+uint64_t const SMALL_LIMIT = uint64_t(1) << 62u;
+size_t const MAX_VARINT = 10;
+
+size_t varint_size(uint64_t x) {
+    size_t res = 1;
+    for (; x >= 0x80; x >>= 7u) {
+        ++res;
+    }
+    return res;
+}
+
+uint8_t* put_varint(uint8_t *p, uint64_t x) {
+    for (; x >= 0x80; x >>= 7u) {
+        *p++ = static_cast<uint8_t>(x | 0x80);
+    }
+    *p++ = static_cast<uint8_t>(x);
+    return p;
+}
+
+size_t padding(size_t offset) {
+    return (4 - offset % 4) % 4;
+}
+
+[[noreturn]] void malformed() {
+    throw std::invalid_argument("deserialize: truncated or malformed input");
+}
+}
+
+big_integer_detail::serialized_header big_integer_detail::read_header(uint8_t const *data, size_t size, size_t& offset) {
+    uint64_t h = 0;
+    for (size_t i = 0;; ++i) {
+        if (offset >= size || i == MAX_VARINT) {
+            malformed();
+        }
+        uint8_t b = data[offset++];
+        if (i + 1 == MAX_VARINT && b > 1) {
+            malformed();
+        }
+        h |= static_cast<uint64_t>(b & 0x7fu) << (7 * i);
+        if (b < 0x80) {
+            break;
+        }
+    }
+    serialized_header res{(h & 2u) != 0, (h & 1u) != 0, h >> 2u, nullptr};
+    if (!res.small) {
+        offset += padding(offset);
+        if (res.value == 0 || offset > size || (size - offset) / 4 < res.value) {
+            malformed();
+        }
+        res.limbs = data + offset;
+        offset += 4 * res.value;
+    }
+    return res;
+}
+
+void serialize(big_integer const& a, std::vector<uint8_t>& out) {
+    size_t n = a.data_.size();
+    uint32_t const *m = a.data_.data();
+    if (n <= 2) {
+        uint64_t magnitude = m[0] | (n == 2 ? static_cast<uint64_t>(m[1]) << 32u : 0);
+        if (magnitude < SMALL_LIMIT) {
+            uint8_t buffer[MAX_VARINT];
+            uint8_t *end = put_varint(buffer, magnitude << 2u | static_cast<uint64_t>(a.sign) << 1u | 1u);
+            out.insert(out.end(), buffer, end);
+            return;
+        }
+    }
+    uint64_t header = static_cast<uint64_t>(n) << 2u | static_cast<uint64_t>(a.sign) << 1u;
+    size_t start = out.size(), limbs = start + varint_size(header);
+    limbs += padding(limbs);
+    // one resize for the whole record, the limbs are little-endian already
+    out.resize(limbs + 4 * n);
+    std::fill(put_varint(out.data() + start, header), out.data() + limbs, 0);
+    std::memcpy(out.data() + limbs, m, 4 * n);
+}
+
+big_integer deserialize(uint8_t const *data, size_t size, size_t& offset) {
+    big_integer_detail::serialized_header h = big_integer_detail::read_header(data, size, offset);
+    big_integer res;
+    if (h.small) {
+        res.set_small(h.value, h.sign);
+        return res;
+    }
+    res.data_.resize(h.value);
+    std::memcpy(res.data_.data(), h.limbs, 4 * h.value);
+    res.sign = h.sign;
+    res.remove_zeros();
+    return res;
+}
@@ -0,0 +1,220 @@
+#include "big_integer.h"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+
+namespace {
+uint32_t const DECIMAL_CHUNK = 1000000000;
+size_t const DECIMAL_DIGITS = 9;
+size_t const BUFFER_SIZE = 256;
+
+// Characters go to the stream buffer BUFFER_SIZE at a time.
+struct output_buffer {
+    explicit output_buffer(std::streambuf *sb) : sb(sb), size(0), failed(false) {}
+
+    void put(char c) {
+        if (size == BUFFER_SIZE) {
+            flush();
+        }
+        data[size++] = c;
+    }
+
+    void fill(char c, size_t n) {
+        for (; n > 0; --n) {
+            put(c);
+        }
+    }
+
+    void flush() {
+        failed |= sb->sputn(data, size) != static_cast<std::streamsize>(size);
+        size = 0;
+    }
+
+    std::streambuf *sb;
+    char data[BUFFER_SIZE];
+    size_t size;
+    bool failed;
+};
+
+unsigned base_of(std::ios_base::fmtflags flags) {
+    std::ios_base::fmtflags field = flags & std::ios_base::basefield;
+    return field == std::ios_base::hex ? 16 : field == std::ios_base::oct ? 8 : field == std::ios_base::dec ? 10 : 0;
+}
+
+int digit_value(int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return 16;
+}
+}
+
+// Decimal digits come from chunks of nine, taken off the magnitude with a precomputed reciprocal
+// and kept as numbers until they are written; hex and octal digits are read straight off the limbs.
+// Either way the length is known before the first character, so the padding needs no string.
+std::ostream& operator<<(std::ostream& s, big_integer const& a) {
+    std::ostream::sentry sentry(s);
+    if (!sentry) {
+        return s;
+    }
+    std::ios_base::fmtflags flags = s.flags();
+    unsigned base = base_of(flags) == 0 ? 10 : base_of(flags);
+    size_t n = a.data_.size();
+    uint32_t const *m = a.data_.data();
+    bool zero = n == 1 && m[0] == 0;
+
+    char prefix[3];
+    size_t prefix_size = 0;
+    if (a.sign || (flags & std::ios_base::showpos)) {
+        prefix[prefix_size++] = a.sign ? '-' : '+';
+    }
+    if ((flags & std::ios_base::showbase) && base != 10 && !zero) {
+        prefix[prefix_size++] = '0';
+        if (base == 16) {
+            prefix[prefix_size++] = (flags & std::ios_base::uppercase) ? 'X' : 'x';
+        }
+    }
+
+    static divisor_1 const chunk_divisor(DECIMAL_CHUNK);
+    scratch_limbs chunks(base == 10 ? n + n / 8 + 2 : 0);
+    size_t count = 0, digits;
+    unsigned digit_bits = base == 16 ? 4 : 3;
+    if (base == 10) {
+        scratch_limbs temp(n);
+        std::copy(m, m + n, temp.data());
+        do {
+            chunks[count++] = chunk_divisor.divrem(temp.data(), temp.data(), n);
+            while (n > 1 && temp[n - 1] == 0) {
+                --n;
+            }
+        } while (n > 1 || temp[0] != 0);
+        digits = DECIMAL_DIGITS * (count - 1) + 1;
+        for (uint32_t top = chunks[count - 1]; top >= 10; top /= 10) {
+            ++digits;
+        }
+    } else {
+        digits = std::max<size_t>(1, (a.bit_length() + digit_bits - 1) / digit_bits);
+    }
+
+    size_t width = s.width() > 0 ? static_cast<size_t>(s.width()) : 0;
+    size_t padding = width > prefix_size + digits ? width - prefix_size - digits : 0;
+    std::ios_base::fmtflags adjust = flags & std::ios_base::adjustfield;
+    output_buffer out(s.rdbuf());
+    if (adjust != std::ios_base::left && adjust != std::ios_base::internal) {
+        out.fill(s.fill(), padding);
+    }
+    for (size_t i = 0; i < prefix_size; ++i) {
+        out.put(prefix[i]);
+    }
+    if (adjust == std::ios_base::internal) {
+        out.fill(s.fill(), padding);
+    }
+    if (base == 10) {
+        char chunk[DECIMAL_DIGITS];
+        for (size_t i = count; i > 0; --i) {
+            uint32_t value = chunks[i - 1];
+            size_t chunk_size = i == count ? digits - DECIMAL_DIGITS * (count - 1) : DECIMAL_DIGITS;
+            for (size_t j = chunk_size; j > 0; --j) {
+                chunk[j - 1] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+            for (size_t j = 0; j < chunk_size; ++j) {
+                out.put(chunk[j]);
+            }
+        }
+    } else {
+        char const *alphabet = (flags & std::ios_base::uppercase) ? "0123456789ABCDEF" : "0123456789abcdef";
+        for (size_t i = digits; i > 0; --i) {
+            size_t bit = (i - 1) * digit_bits, limb = bit / 32, shift = bit % 32;
+            uint64_t window = m[limb] | (limb + 1 < a.data_.size() ? static_cast<uint64_t>(m[limb + 1]) << 32u : 0);
+            out.put(alphabet[(window >> shift) & (base - 1)]);
+        }
+    }
+    if (adjust == std::ios_base::left) {
+        out.fill(s.fill(), padding);
+    }
+    out.flush();
+    s.width(0);
+    if (out.failed) {
+        s.setstate(std::ios_base::badbit);
+    }
+    return s;
+}
+
+// Digits are gathered into a machine word and folded into the value with the single-limb kernels.
+// Without a base flag the base follows the prefix, 0x for hex and 0 for octal, as with strtol.
+std::istream& operator>>(std::istream& s, big_integer& a) {
+    std::istream::sentry sentry(s);
+    if (!sentry) {
+        return s;
+    }
+    std::streambuf *sb = s.rdbuf();
+    unsigned base = base_of(s.flags());
+    int c = sb->sgetc();
+    bool negative = false;
+    if (c == '-' || c == '+') {
+        negative = c == '-';
+        c = sb->snextc();
+    }
+    bool any = false;
+    if (c == '0' && base != 10) {
+        any = true;
+        c = sb->snextc();
+        if ((c == 'x' || c == 'X') && base != 8) {
+            base = 16;
+            any = false;
+            c = sb->snextc();
+        } else if (base == 0) {
+            base = 8;
+        }
+    }
+    if (base == 0) {
+        base = 10;
+    }
+    // the largest power of the base that fits a limb
+    uint32_t scale = 1;
+    while (scale <= UINT32_MAX / base) {
+        scale *= base;
+    }
+
+    big_integer res;
+    uint32_t chunk = 0, chunk_scale = 1;
+    for (; c != std::char_traits<char>::eof(); c = sb->snextc()) {
+        unsigned d = digit_value(c);
+        if (d >= base) {
+            break;
+        }
+        any = true;
+        chunk = chunk * base + d;
+        chunk_scale *= base;
+        if (chunk_scale == scale) {
+            res *= chunk_scale;
+            res += chunk;
+            chunk = 0;
+            chunk_scale = 1;
+        }
+    }
+    res *= chunk_scale;
+    res += chunk;
+
+    std::ios_base::iostate state = std::ios_base::goodbit;
+    if (c == std::char_traits<char>::eof()) {
+        state |= std::ios_base::eofbit;
+    }
+    if (any) {
+        res.sign = negative && !res.is_zero();
+        a = res;
+    } else {
+        a = 0;
+        state |= std::ios_base::failbit;
+    }
+    s.setstate(state);
+    return s;
+}
@@ -1,13 +1,23 @@
 #include <algorithm>
+#include <cstdio>
 #include <cassert>
 #include <cstdlib>
+#include <memory_resource>
 #include <random>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
+#include "big_accumulator.h"
+#include "big_integer_batch.h"
 #include "big_integer_gmp.h"
+#include "big_integer_mod.h"
+#include "big_integer_view.h"
+#include "wide_int.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -835,3 +845,952 @@ TEST(correctness_twos_complement, all_ones) {
 
   EXPECT_EQ(to_string(gmp_ans), to_string(your_ans));
 }
+
+namespace {
+struct counting_resource : std::pmr::memory_resource {
+  size_t allocations = 0;
+  size_t live = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    ++live;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    --live;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    return this == &other;
+  }
+};
+}
+
+TEST(correctness_allocation, resource_scope) {
+  counting_resource resource;
+  big_integer a = rand_big(20);
+  big_integer b = rand_big(20);
+  big_integer c;
+  {
+    limb_resource_scope scope(&resource);
+    big_integer t = a * b;
+    c = t / b;
+  }
+  EXPECT_GT(resource.allocations, 0u);
+  EXPECT_EQ(0u, resource.live);
+  EXPECT_EQ(a, c);
+}
+
+TEST(correctness_allocation, arena_results_outlive_arena) {
+  big_integer a = rand_big(30);
+  big_integer b = rand_big(25);
+  big_integer q, r;
+  {
+    big_integer_arena arena;
+    q = a / b;
+    r = a % b;
+  }
+  EXPECT_EQ(a, q * b + r);
+}
+
+TEST(correctness_allocation, arena_copies_outlive_arena) {
+  big_integer a = rand_big(30);
+  std::vector<big_integer> out;
+  {
+    big_integer_arena arena;
+    big_integer t = a;
+    t *= a;
+    out.push_back(t);
+    out.push_back(t);
+    t += 1;
+    out.push_back(t);
+    big_integer s = 5;
+    out.push_back(s);
+    out.emplace_back(7);
+  }
+  EXPECT_EQ(a * a, out[0]);
+  out[1] += 1;
+  EXPECT_EQ(out[2], out[1]);
+  EXPECT_EQ(a * a, out[0]);
+  out[3] <<= 2000;
+  out[4] *= a;
+  EXPECT_EQ(big_integer(5) << 2000, out[3]);
+  EXPECT_EQ(a * 7, out[4]);
+}
+
+TEST(correctness_allocation, pool_steady_state) {
+  big_integer a = rand_big(40);
+  big_integer b = rand_big(30);
+  big_integer c = a * b / b;
+  limb_pool::reset_stats();
+  for (size_t i = 0; i != number_of_iterations; ++i) {
+    c = a * b / b;
+  }
+  limb_pool_stats stats = limb_pool::stats();
+  EXPECT_GT(stats.hits, 0u);
+  EXPECT_EQ(0u, stats.misses);
+  EXPECT_EQ(a, c);
+}
+
+TEST(correctness_twos_complement, different_lengths) {
+  std::default_random_engine rng(7);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(max_size, rng);
+    b.random(max_size / 16, rng);
+    big_integer A(to_string(a)), B(to_string(b));
+
+    EXPECT_EQ(to_string(a & b), to_string(A & B));
+    EXPECT_EQ(to_string(b | a), to_string(B | A));
+    EXPECT_EQ(to_string(a ^ -b), to_string(A ^ -B));
+    EXPECT_EQ(to_string(-a & -b), to_string(-A & -B));
+  }
+}
+
+TEST(correctness_twos_complement, self) {
+  big_integer a("-340282366920938463463374607431768211456"); // -(1 << 128)
+  big_integer b = a;
+  b &= b;
+  EXPECT_EQ(a, b);
+  b |= b;
+  EXPECT_EQ(a, b);
+  b ^= b;
+  EXPECT_EQ(0, b);
+}
+
+TEST(correctness, shr_signed_exact) {
+  big_integer a = -1024;
+
+  EXPECT_EQ(-128, a >> 3);
+  EXPECT_EQ(-1, a >> 10);
+  EXPECT_EQ(-1, a >> 100);
+  EXPECT_EQ(0, big_integer(1024) >> 100);
+}
+
+TEST(correctness_random, word_shifts) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size, rng);
+    big_integer R = big_integer(to_string(a));
+    for (int shift : {32, 64, 96, 32 * static_cast<int>(itn)}) {
+      EXPECT_EQ(to_string(a << shift), to_string(R << shift));
+      EXPECT_EQ(to_string(a >> shift), to_string(R >> shift));
+      EXPECT_EQ(to_string((a << shift) >> shift), to_string((R << shift) >> shift));
+    }
+  }
+}
+
+TEST(correctness, three_way_compare) {
+  big_integer a = 100;
+  big_integer b = -200;
+
+  EXPECT_EQ(1, compare(a, b));
+  EXPECT_EQ(-1, compare(b, a));
+  EXPECT_EQ(0, compare(a, a));
+  EXPECT_EQ(-1, compare_abs(a, b));
+  EXPECT_EQ(1, compare_abs(b, a));
+  EXPECT_EQ(0, compare_abs(-a, a));
+  EXPECT_EQ(0, compare(big_integer(0), -big_integer(0)));
+}
+
+TEST(correctness_random, three_way_compare) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(max_size, rng);
+    b.random(max_size, rng);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    EXPECT_EQ((a > b) - (a < b), compare(A, B));
+    EXPECT_EQ(-compare(A, B), compare(B, A));
+    EXPECT_EQ(0, compare(A, big_integer(to_string(a))));
+  }
+}
+
+TEST(correctness, machine_integer_limits) {
+  int64_t min = std::numeric_limits<int64_t>::min();
+  uint64_t max = std::numeric_limits<uint64_t>::max();
+  big_integer a = min;
+  big_integer b = max;
+
+  EXPECT_EQ(big_integer("-9223372036854775808"), a);
+  EXPECT_EQ(big_integer("18446744073709551615"), b);
+  EXPECT_EQ(big_integer("18446744073709551616"), b + 1u);
+  EXPECT_EQ(big_integer("-18446744073709551616"), -b - 1);
+  EXPECT_EQ(0, b % max);
+  EXPECT_EQ(1, a / min);
+  EXPECT_TRUE(a < 0);
+  EXPECT_TRUE(max > a);
+  EXPECT_TRUE(b == max);
+
+  __extension__ typedef __int128 int128;
+  static_assert(!std::is_convertible_v<int128, big_integer>, "128-bit values would be truncated");
+}
+
+TEST(correctness_random, machine_integer_operands) {
+  std::default_random_engine rng(42);
+  std::uniform_int_distribution<int64_t> signed_values(std::numeric_limits<int64_t>::min());
+  std::uniform_int_distribution<uint64_t> unsigned_values(1);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (size_t size : {size_t(40), size_t(70), max_size}) {
+      big_integer_gmp a;
+      a.random(size, rng);
+      big_integer A(to_string(a));
+      int64_t v = signed_values(rng);
+      uint64_t u = unsigned_values(rng);
+      big_integer_gmp g(std::to_string(v)), h(std::to_string(u));
+
+      EXPECT_EQ(to_string(a + g), to_string(A + v));
+      EXPECT_EQ(to_string(a - g), to_string(A - v));
+      EXPECT_EQ(to_string(g - a), to_string(v - A));
+      EXPECT_EQ(to_string(a * g), to_string(A * v));
+      EXPECT_EQ(to_string(a / g), to_string(A / v));
+      EXPECT_EQ(to_string(a % g), to_string(A % v));
+      EXPECT_EQ(to_string(a + h), to_string(u + A));
+      EXPECT_EQ(to_string(a - h), to_string(A - u));
+      EXPECT_EQ(to_string(a * h), to_string(u * A));
+      EXPECT_EQ(to_string(a / h), to_string(A / u));
+      EXPECT_EQ(to_string(a % h), to_string(A % u));
+      EXPECT_EQ(a < g, A < v);
+      EXPECT_EQ(a > h, A > u);
+      EXPECT_EQ(a == g, A == v);
+    }
+  }
+}
+
+TEST(correctness, divexact) {
+  big_integer a("115792089237316195423570985008687907853269984665640564039457584007913129639936");
+  big_integer b("340282366920938463463374607431768211456");
+
+  EXPECT_EQ(b, divexact(a, b));
+  EXPECT_EQ(-b, divexact(-a, b));
+  EXPECT_EQ(0, divexact(0, b));
+  EXPECT_EQ(-7, divexact(-21, 3));
+  EXPECT_EQ(big_integer("3039121913590135040"), divexact(big_integer("-3039121913590135040"), -1));
+}
+
+TEST(correctness_random, divexact) {
+  std::default_random_engine rng(322);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (size_t size : {size_t(20), size_t(31), size_t(200), max_size / 2}) {
+      big_integer_gmp a, b;
+      a.random(max_size, rng);
+      b.random(size, rng);
+      if (b == 0) {
+        continue;
+      }
+      big_integer A(to_string(a)), B(to_string(b));
+      big_integer P = A * B;
+      EXPECT_EQ(to_string(a), to_string(divexact(P, B)));
+      EXPECT_EQ(to_string(b), to_string(divexact(P << 3, A << 3)));
+    }
+  }
+}
+
+TEST(correctness_random, divisor_1) {
+  std::default_random_engine rng(322);
+  std::uniform_int_distribution<uint32_t> divisors(1);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size, rng);
+    big_integer A(to_string(a));
+    for (uint32_t d : {1u, 3u, 1000000000u, 0x80000000u, 0xFFFFFFFFu, divisors(rng)}) {
+      divisor_1 divisor(d);
+      big_integer Q = A;
+      uint32_t r = divrem(Q, divisor);
+      EXPECT_EQ(to_string(a / big_integer_gmp(std::to_string(d))), to_string(Q));
+      EXPECT_EQ(A, Q * d + (A < 0 ? -big_integer(r) : big_integer(r)));
+    }
+  }
+}
+
+TEST(correctness, gcd) {
+  EXPECT_EQ(6, gcd(big_integer(12), 18));
+  EXPECT_EQ(6, gcd(big_integer(-12), 18));
+  EXPECT_EQ(5, gcd(big_integer(0), -5));
+  EXPECT_EQ(0, gcd(big_integer(0), 0));
+
+  big_integer s, t;
+  EXPECT_EQ(2, gcdext(240, 46, s, t));
+  EXPECT_EQ(2, s * 240 + t * 46);
+  EXPECT_EQ(4, invert(3, 11));
+  EXPECT_EQ(7, invert(-3, 11));
+  EXPECT_THROW(invert(6, 9), std::domain_error);
+}
+
+TEST(correctness_random, gcd) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (size_t size : {size_t(60), size_t(200), max_size}) {
+      big_integer_gmp g, a, b;
+      g.random(size / 2, rng);
+      a.random(size, rng);
+      b.random(size / 3 * 2, rng);
+      big_integer G(to_string(g)), A(to_string(a)), B(to_string(b));
+      A *= G;
+      B *= G;
+      big_integer_gmp c(to_string(A)), d(to_string(B));
+      EXPECT_EQ(to_string(gcd(c, d)), to_string(gcd(A, B)));
+
+      big_integer s, t;
+      big_integer r = gcdext(A, B, s, t);
+      EXPECT_EQ(to_string(gcd(c, d)), to_string(r));
+      EXPECT_EQ(r, s * A + t * B);
+      EXPECT_LE(s.bit_length(), B.bit_length());
+      EXPECT_LE(t.bit_length(), A.bit_length());
+    }
+  }
+}
+
+TEST(correctness_random, invert) {
+  std::default_random_engine rng(42);
+  big_integer m("170141183460469231731687303715884105727"); // 2^127 - 1 is prime
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size, rng);
+    big_integer A(to_string(a));
+    if (A % m == 0) {
+      continue;
+    }
+    big_integer x = invert(A, m);
+    EXPECT_GE(x, 0);
+    EXPECT_LT(x, m);
+    big_integer one = A * x % m;
+    EXPECT_EQ(1, one < 0 ? one + m : one);
+  }
+}
+
+TEST(correctness, roots) {
+  EXPECT_EQ(0, isqrt(0));
+  EXPECT_EQ(1, isqrt(3));
+  EXPECT_EQ(2, isqrt(4));
+  EXPECT_EQ(-3, iroot(big_integer(-27), 3));
+  EXPECT_EQ(-3, iroot(big_integer(-63), 3));
+  EXPECT_EQ(big_integer("1000000000000000000000"), isqrt(big_integer("1000000000000000000000000000000000000000000")));
+  EXPECT_EQ(1024, pow(big_integer(2), 10));
+  EXPECT_THROW(iroot(big_integer(-4), 2), std::domain_error);
+  EXPECT_THROW(iroot(big_integer(4), 0), std::domain_error);
+
+  EXPECT_TRUE(is_perfect_power(big_integer(1)));
+  EXPECT_TRUE(is_perfect_power(big_integer(-8)));
+  EXPECT_FALSE(is_perfect_power(big_integer(-4)));
+  EXPECT_FALSE(is_perfect_power(big_integer(12)));
+  EXPECT_TRUE(is_perfect_power(pow(big_integer(3), 61)));
+  EXPECT_FALSE(is_perfect_power(pow(big_integer(3), 61) + 1));
+}
+
+TEST(correctness_random, roots) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size, rng);
+    big_integer A(to_string(a));
+    for (uint32_t n : {1u, 2u, 3u, 5u, 17u, 100u}) {
+      if (A < 0 && n % 2 == 0) {
+        continue;
+      }
+      EXPECT_EQ(to_string(iroot(a, n)), to_string(iroot(A, n)));
+    }
+    big_integer r = isqrt(A < 0 ? -A : A) + itn % 2;
+    big_integer_gmp square(to_string(r * r));
+    EXPECT_EQ(is_perfect_power(square), is_perfect_power(r * r));
+    EXPECT_EQ(is_perfect_power(square + 1), is_perfect_power(r * r + 1));
+  }
+}
+
+TEST(correctness, primes) {
+  EXPECT_EQ(445, powmod(big_integer(4), big_integer(13), big_integer(497)));
+  EXPECT_EQ(0, powmod(big_integer(4), big_integer(13), big_integer(1)));
+  EXPECT_EQ(1, powmod(big_integer(-3), big_integer(0), big_integer(10)));
+  EXPECT_EQ(7, powmod(big_integer(-3), big_integer(3), big_integer(17)));
+  EXPECT_EQ(4, powmod(big_integer(3), big_integer(-1), big_integer(11)));
+  EXPECT_THROW(powmod(big_integer(3), big_integer(2), big_integer(0)), std::domain_error);
+
+  EXPECT_FALSE(is_probable_prime(big_integer(-7)));
+  EXPECT_FALSE(is_probable_prime(big_integer(1)));
+  EXPECT_TRUE(is_probable_prime(big_integer(2)));
+  EXPECT_TRUE(is_probable_prime(big_integer(997)));
+  EXPECT_TRUE(is_probable_prime(big_integer(1000003)));
+  EXPECT_FALSE(is_probable_prime(big_integer(1009) * 1013));
+  // strong pseudoprime to base 2, caught by the Lucas part
+  EXPECT_FALSE(is_probable_prime(big_integer(25326001)));
+  EXPECT_TRUE(is_probable_prime(big_integer("170141183460469231731687303715884105727"), 5));
+  EXPECT_FALSE(is_probable_prime(big_integer("170141183460469231731687303715884105727") * big_integer("2305843009213693951")));
+  EXPECT_FALSE(is_probable_prime(pow(big_integer(1000003), 2)));
+
+  EXPECT_EQ(2, next_prime(big_integer(-5)));
+  EXPECT_EQ(3, next_prime(big_integer(2)));
+  EXPECT_EQ(1009, next_prime(big_integer(997)));
+}
+
+TEST(correctness_random, primes) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    for (size_t size : {size_t(30), size_t(100), size_t(500)}) {
+      big_integer_gmp a, e, m;
+      a.random(size, rng);
+      e.random(size, rng);
+      m.random(size, rng);
+      big_integer A(to_string(a)), E(to_string(e)), M(to_string(m));
+      if (E < 0) {
+        E = -E;
+        e = big_integer_gmp(to_string(E));
+      }
+      if (M == 0) {
+        continue;
+      }
+      if (M < 0) {
+        M = -M;
+        m = big_integer_gmp(to_string(M));
+      }
+      EXPECT_EQ(to_string(powmod(a, e, m)), to_string(powmod(A, E, M)));
+
+      big_integer P = next_prime(A);
+      big_integer_gmp p(to_string(A < 0 ? big_integer(1) : A));
+      EXPECT_EQ(to_string(next_prime(p)), to_string(P));
+      EXPECT_TRUE(is_probable_prime(P, 2));
+      EXPECT_FALSE(is_probable_prime(P * next_prime(P)));
+      EXPECT_EQ(is_probable_prime(big_integer_gmp(to_string(M)), 25), is_probable_prime(M, 2));
+    }
+  }
+}
+
+TEST(correctness, combinatorics) {
+  EXPECT_EQ(1, factorial(0));
+  EXPECT_EQ(1, factorial(1));
+  EXPECT_EQ(120, factorial(5));
+  EXPECT_EQ(big_integer("2432902008176640000"), factorial(20));
+  EXPECT_EQ(0, binomial(3, 5));
+  EXPECT_EQ(1, binomial(7, 0));
+  EXPECT_EQ(252, binomial(10, 5));
+  EXPECT_EQ(big_integer("100891344545564193334812497256"), binomial(100, 50));
+  EXPECT_EQ(1, primorial(1));
+  EXPECT_EQ(big_integer(6469693230), primorial(30));
+}
+
+TEST(correctness_random, combinatorics) {
+  std::default_random_engine rng(42);
+  unsigned threads = get_big_integer_threads();
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    unsigned long n = 1000 + rng() % 20000, k = rng() % n;
+    set_big_integer_threads(itn % 2 ? 1 : 4);
+    EXPECT_EQ(to_string(big_integer_gmp::factorial(n)), to_string(factorial(n)));
+    EXPECT_EQ(to_string(big_integer_gmp::binomial(n, k)), to_string(binomial(n, k)));
+    EXPECT_EQ(to_string(big_integer_gmp::binomial(n, k % 40)), to_string(binomial(n, k % 40)));
+    EXPECT_EQ(to_string(big_integer_gmp::primorial(n)), to_string(primorial(n)));
+  }
+  set_big_integer_threads(threads);
+}
+
+TEST(correctness_random, mul_threads) {
+  std::default_random_engine rng(42);
+  unsigned threads = get_big_integer_threads();
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(32 * (1000 + rng() % 3000), rng);
+    b.random(32 * (itn % 2 ? 1000 + rng() % 3000 : 10 + rng() % 200), rng);
+    big_integer A(to_string(a)), B(to_string(b));
+    set_big_integer_threads(1);
+    big_integer single = A * B;
+    EXPECT_EQ(to_string(a * b), to_string(single));
+    set_big_integer_threads(2 + itn % 7);
+    EXPECT_EQ(single, A * B);
+  }
+  set_big_integer_threads(threads);
+}
+
+TEST(correctness, batch) {
+  big_integer_batch a(3, 2), b(3, 2);
+  a.set(0, 5);
+  b.set(0, -7);
+  a.set(1, big_integer("18446744073709551615"));
+  b.set(1, 1);
+  a.set(2, -1);
+  b.set(2, -1);
+  add(a, a, b);
+  EXPECT_EQ(-2, a.get(0));
+  EXPECT_EQ(0, a.get(1));
+  EXPECT_EQ(-2, a.get(2));
+  mul(a, a, b);
+  EXPECT_EQ(14, a.get(0));
+  EXPECT_EQ(2, a.get(2));
+  int8_t order[3];
+  compare(order, a, b);
+  EXPECT_EQ(1, order[0]);
+  EXPECT_EQ(-1, order[1]);
+  EXPECT_EQ(1, order[2]);
+  EXPECT_THROW(add(a, a, big_integer_batch(3, 4)), std::invalid_argument);
+}
+
+TEST(correctness_random, batch) {
+  std::default_random_engine rng(42);
+  for (size_t limbs : {size_t(1), size_t(8), size_t(16)}) {
+    size_t lanes = 1 + rng() % 200;
+    big_integer_batch a(lanes, limbs), b(lanes, limbs), sum(lanes, limbs), difference(lanes, limbs), product(lanes, limbs);
+    std::vector<big_integer> x, y;
+    for (size_t i = 0; i != lanes; ++i) {
+      x.push_back(rand_big(rng() % (limbs + 2)) * (rng() % 2 ? 1 : -1));
+      y.push_back(rand_big(rng() % (limbs + 2)) * (rng() % 2 ? 1 : -1));
+      a.set(i, x[i]);
+      b.set(i, y[i]);
+    }
+    add(sum, a, b);
+    sub(difference, a, b);
+    mul(product, a, b);
+    std::vector<int8_t> order(lanes);
+    compare(order.data(), a, b);
+    // reference values are reduced to the signed range of the width
+    big_integer modulus = big_integer(1) << static_cast<int>(32 * limbs), half = modulus >> 1;
+    auto wrap = [&](big_integer v) {
+      v %= modulus;
+      if (v < -half) {
+        v += modulus;
+      } else if (v >= half) {
+        v -= modulus;
+      }
+      return v;
+    };
+    for (size_t i = 0; i != lanes; ++i) {
+      EXPECT_EQ(wrap(x[i]), a.get(i));
+      EXPECT_EQ(wrap(x[i] + y[i]), sum.get(i));
+      EXPECT_EQ(wrap(x[i] - y[i]), difference.get(i));
+      EXPECT_EQ(wrap(x[i] * y[i]), product.get(i));
+      EXPECT_EQ(compare(wrap(x[i]), wrap(y[i])), order[i]);
+    }
+  }
+}
+
+TEST(correctness, product_and_sum) {
+  std::vector<big_integer> empty;
+  EXPECT_EQ(1, product(empty.begin(), empty.end()));
+  EXPECT_EQ(0, sum(empty.begin(), empty.end()));
+
+  std::vector<big_integer> v = {3, -4, 5};
+  EXPECT_EQ(-60, product(v.begin(), v.end()));
+  EXPECT_EQ(4, sum(v.begin(), v.end()));
+}
+
+TEST(correctness_random, product_and_sum) {
+  std::default_random_engine rng(42);
+  unsigned threads = get_big_integer_threads();
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    std::vector<big_integer> v;
+    big_integer expected_product = 1, expected_sum = 0;
+    size_t count = 1 + rng() % 500;
+    for (size_t i = 0; i != count; ++i) {
+      v.push_back(rand_big(rng() % 40) * (rng() % 2 ? 1 : -1));
+      expected_product *= v.back();
+      expected_sum += v.back();
+    }
+    set_big_integer_threads(itn % 2 ? 1 : 4);
+    EXPECT_EQ(expected_product, product(v.begin(), v.end()));
+    EXPECT_EQ(expected_sum, sum(v.begin(), v.end()));
+  }
+  set_big_integer_threads(threads);
+}
+
+TEST(correctness_random, product_of_shared_values) {
+  std::default_random_engine rng(42);
+  unsigned threads = get_big_integer_threads();
+  set_big_integer_threads(4);
+  for (size_t itn = 0; itn != 10; ++itn) {
+    // every factor is large enough to be a leaf of its own, and all of them share one buffer
+    big_integer x = rand_big(2100 + rng() % 100);
+    std::vector<big_integer> v(8, x);
+    v.push_back(x);
+    big_integer square = x * x, fourth = square * square;
+    EXPECT_EQ(fourth * fourth * x, product(v.begin(), v.end()));
+    EXPECT_EQ(x * 9, sum(v.begin(), v.end()));
+  }
+  set_big_integer_threads(threads);
+}
+
+TEST(correctness, wide_int) {
+  constexpr wide_int<128> a = (wide_int<128>(1) << 100) - 1;
+  static_assert(a.bit_length() == 100);
+  static_assert(a / (wide_int<128>(1) << 50) == (wide_int<128>(1) << 50) - 1);
+  static_assert(a * a == 1 - (wide_int<128>(1) << 101));
+  static_assert(wide_int<128>(-7) / 2 == -3 && wide_int<128>(-7) % 2 == -1);
+  static_assert((wide_int<256>(-7) >> 1) == -4);
+  static_assert(wide_int<128>(-1) < 0 && wide_uint<128>(-1) > 0);
+  static_assert(wide_uint<128>(wide_int<64>(-1)) == wide_uint<128>(UINT64_MAX) * UINT64_MAX + 2 * wide_uint<128>(UINT64_MAX));
+
+  EXPECT_EQ("1267650600228229401496703205375", to_string(a));
+  EXPECT_EQ(big_integer("1267650600228229401496703205375"), big_integer(a));
+  EXPECT_EQ(a, wide_int<128>(big_integer("1267650600228229401496703205375")));
+  EXPECT_EQ(-a, wide_int<128>(big_integer("-1267650600228229401496703205375")));
+  EXPECT_EQ(1, wide_int<128>(big_integer(1) << 128 | 1));
+  EXPECT_EQ("-170141183460469231731687303715884105728", to_string(wide_int<128>(1) << 127));
+  EXPECT_EQ("340282366920938463463374607431768211455", to_string(wide_uint<128>(-1)));
+}
+
+namespace {
+template <size_t Bits, bool Signed>
+void test_wide_int(std::default_random_engine& rng) {
+  using wide = wide_int<Bits, Signed>;
+  big_integer_gmp modulus = big_integer_gmp(1) << static_cast<int>(Bits), half = modulus >> 1;
+  // reference values are reduced to the range of the type
+  auto wrap = [&](big_integer_gmp v) {
+    v &= modulus - 1;
+    if (Signed && v >= half) {
+      v -= modulus;
+    }
+    return v;
+  };
+  for (size_t itn = 0; itn != 100 * number_of_iterations; ++itn) {
+    big_integer_gmp a = wrap(big_integer_gmp(to_string(rand_big(rng() % (Bits / 31 + 1)) * (rng() % 2 ? 1 : -1))));
+    big_integer_gmp b = wrap(big_integer_gmp(to_string(rand_big(rng() % (Bits / 31 + 1)) * (rng() % 2 ? 1 : -1))));
+    wide x(big_integer(to_string(a))), y(big_integer(to_string(b)));
+    int shift = static_cast<int>(rng() % Bits);
+    EXPECT_EQ(to_string(a), to_string(x));
+    EXPECT_EQ(to_string(wrap(a + b)), to_string(x + y));
+    EXPECT_EQ(to_string(wrap(a - b)), to_string(x - y));
+    EXPECT_EQ(to_string(wrap(a * b)), to_string(x * y));
+    EXPECT_EQ(to_string(wrap(a & b)), to_string(x & y));
+    EXPECT_EQ(to_string(wrap(a | b)), to_string(x | y));
+    EXPECT_EQ(to_string(wrap(a ^ b)), to_string(x ^ y));
+    EXPECT_EQ(to_string(wrap(~a)), to_string(~x));
+    EXPECT_EQ(to_string(wrap(-a)), to_string(-x));
+    EXPECT_EQ(to_string(wrap(a << shift)), to_string(x << shift));
+    EXPECT_EQ(to_string(wrap(a >> shift)), to_string(x >> shift));
+    EXPECT_EQ(a < b, x < y);
+    EXPECT_EQ(a == b, x == y);
+    if (b != 0) {
+      EXPECT_EQ(to_string(wrap(a / b)), to_string(x / y));
+      EXPECT_EQ(to_string(wrap(a % b)), to_string(x % y));
+    }
+  }
+}
+}
+
+TEST(correctness_random, wide_int) {
+  std::default_random_engine rng(42);
+  test_wide_int<64, true>(rng);
+  test_wide_int<128, false>(rng);
+  test_wide_int<192, true>(rng);
+  test_wide_int<256, false>(rng);
+  test_wide_int<512, true>(rng);
+}
+
+TEST(correctness, literals) {
+  constexpr auto p = 115792089237316195423570985008687907853269984665640564039457584007908834671663_bi;
+  static_assert(wide_uint<256>(p) == -(wide_uint<256>(1) << 32) - 977);
+  static_assert(wide_int<64>(-0x7fff'ffff_bi) == -0x7fffffff);
+  static_assert(wide_int<64>(0b101_bi) == 5 && wide_int<64>(017_bi) == 15 && wide_int<64>(0_bi) == 0);
+
+  big_integer a = p;
+  EXPECT_EQ((big_integer(1) << 256) - (big_integer(1) << 32) - 977, a);
+  big_integer b = -0xDEAD'BEEF'0123'4567'89ab'cdef_bi;
+  EXPECT_EQ(big_integer("-68915718005617500482515488239"), b);
+  big_integer c = 1000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000_bi;
+  EXPECT_EQ(pow(big_integer(10), 99), c);
+  EXPECT_EQ(0, big_integer(-0_bi));
+}
+
+TEST(correctness, serialize) {
+  std::vector<uint8_t> out;
+  serialize(0, out);
+  serialize(-1, out);
+  serialize(big_integer(1) << 62, out);
+  std::vector<uint8_t> expected = {0x01, 0x07, 0x08, 0, 0, 0, 0, 0, 0, 0, 0, 0x40};
+  EXPECT_EQ(expected, out);
+
+  size_t offset = 0;
+  EXPECT_EQ(0, deserialize(out.data(), out.size(), offset));
+  EXPECT_EQ(-1, deserialize(out.data(), out.size(), offset));
+  EXPECT_EQ(big_integer(1) << 62, deserialize(out.data(), out.size(), offset));
+  EXPECT_EQ(out.size(), offset);
+
+  offset = 2;
+  EXPECT_THROW(deserialize(out.data(), out.size() - 1, offset), std::invalid_argument);
+  offset = 0;
+  std::vector<uint8_t> endless(11, 0xff);
+  EXPECT_THROW(deserialize(endless.data(), endless.size(), offset), std::invalid_argument);
+}
+
+TEST(correctness_random, serialize) {
+  std::default_random_engine rng(42);
+  std::vector<big_integer> values;
+  std::vector<uint8_t> out;
+  for (size_t itn = 0; itn != 100 * number_of_iterations; ++itn) {
+    values.push_back(rand_big(rng() % 40) * (rng() % 2 ? 1 : -1) >> static_cast<int>(rng() % 64));
+    serialize(values.back(), out);
+  }
+  size_t offset = 0;
+  for (big_integer const& v : values) {
+    EXPECT_EQ(v, deserialize(out.data(), out.size(), offset));
+  }
+  EXPECT_EQ(out.size(), offset);
+}
+
+TEST(correctness, view) {
+  big_integer a = -(big_integer(1) << 200) + 12345, b = 7;
+  std::vector<uint8_t> out;
+  serialize(a, out);
+  serialize(b, out);
+  size_t offset = 0;
+  big_integer_view x(out.data(), out.size(), offset), y(out.data(), out.size(), offset);
+  EXPECT_EQ(out.size(), offset);
+  EXPECT_EQ(a, x);
+  EXPECT_EQ(b, y);
+  EXPECT_TRUE(x < y);
+  EXPECT_EQ(to_string(a), to_string(x));
+  EXPECT_EQ(a * a, big_integer(1) * x * x);
+  EXPECT_EQ(a / b, a / y);
+
+  // copies own their limbs
+  big_integer c = x;
+  c += 1;
+  out[8] ^= 1;
+  EXPECT_EQ(a + 1, c);
+  EXPECT_NE(a, x);
+
+  // records with leading zero limbs read as deserialize reads them
+  std::vector<uint8_t> padded = {3 << 2 | 2, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                 2 << 2 | 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  for (size_t start : {size_t(0), size_t(16)}) {
+    size_t view_offset = start, copy_offset = start;
+    big_integer_view z(padded.data(), padded.size(), view_offset);
+    big_integer expected = deserialize(padded.data(), padded.size(), copy_offset);
+    EXPECT_EQ(copy_offset, view_offset);
+    EXPECT_EQ(expected, z);
+    EXPECT_EQ(to_string(expected), to_string(z));
+  }
+}
+
+TEST(correctness_random, view) {
+  std::default_random_engine rng(42);
+  std::vector<big_integer> values;
+  std::vector<uint8_t> out;
+  for (size_t itn = 0; itn != 100 * number_of_iterations; ++itn) {
+    values.push_back(rand_big(rng() % 40) * (rng() % 2 ? 1 : -1));
+    serialize(values.back(), out);
+  }
+  char const *path = "big_integer_view_testing.bin";
+  FILE *f = std::fopen(path, "wb");
+  ASSERT_NE(nullptr, f);
+  std::fwrite(out.data(), 1, out.size(), f);
+  std::fclose(f);
+  {
+    mapped_file file(path);
+    size_t offset = 0;
+    for (size_t i = 0; i + 1 < values.size(); ++i) {
+      big_integer_view v(file.data(), file.size(), offset);
+      EXPECT_EQ(values[i], v);
+      EXPECT_EQ(values[i + 1] - values[i], values[i + 1] - v);
+      EXPECT_EQ(values[i + 1] * values[i], values[i + 1] * v.value());
+      EXPECT_EQ(compare(values[i], values[i + 1]), compare(v, values[i + 1]));
+    }
+  }
+  std::remove(path);
+  EXPECT_THROW(mapped_file("big_integer_view_testing.missing"), std::system_error);
+}
+
+TEST(correctness, hash) {
+  std::hash<big_integer> h;
+  big_integer a = big_integer("123456789012345678901234567890"), b = a;
+  EXPECT_EQ(h(a), h(b));
+  EXPECT_EQ(h(a), h(a * 3 / 3));
+  EXPECT_EQ(h(0), h(big_integer(5) - 5));
+  EXPECT_NE(h(a), h(-a));
+  EXPECT_NE(h(1), h(big_integer(1) << 32));
+}
+
+TEST(correctness_random, hash) {
+  std::default_random_engine rng(42);
+  std::vector<big_integer> values;
+  std::unordered_set<big_integer> set;
+  for (size_t itn = 0; itn != 100 * number_of_iterations; ++itn) {
+    values.push_back(rand_big(rng() % 20) * (rng() % 2 ? 1 : -1));
+    set.insert(values.back());
+  }
+  for (big_integer const& v : values) {
+    // an equal value built apart from v, not sharing its limbs
+    EXPECT_EQ(1u, set.count(big_integer(to_string(v))));
+    EXPECT_EQ(std::hash<big_integer>()(v), std::hash<big_integer>()(big_integer(to_string(v))));
+  }
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(size_t(std::unique(values.begin(), values.end()) - values.begin()), set.size());
+}
+
+TEST(correctness, accumulator) {
+  big_accumulator acc;
+  EXPECT_EQ(0, acc.value());
+  acc += big_integer("18446744073709551615");
+  acc += 1;
+  EXPECT_EQ(big_integer(1) << 64, acc.value());
+  acc -= big_integer(1) << 65;
+  EXPECT_EQ(-(big_integer(1) << 64), acc.value());
+  acc += -3;
+  acc -= -3;
+  acc += big_integer(1) << 64;
+  EXPECT_EQ(0, acc.value());
+}
+
+TEST(correctness_random, accumulator) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_accumulator acc;
+    big_integer expected = 0;
+    for (size_t i = 0; i != 1000; ++i) {
+      big_integer x = rand_big(rng() % 30) * (rng() % 2 ? 1 : -1);
+      if (rng() % 4 == 0) {
+        acc -= x;
+        expected -= x;
+      } else {
+        acc += x;
+        expected += x;
+      }
+      if (i % 100 == 0) {
+        EXPECT_EQ(expected, acc.value());
+      }
+    }
+    EXPECT_EQ(expected, acc.value());
+  }
+}
+
+TEST(correctness, mod_value) {
+  mod_context p(big_integer(-7));
+  EXPECT_EQ(7, p.modulus());
+  mod_value a(p, 12), b(p, big_integer(-3));
+  EXPECT_EQ(5, a.value());
+  EXPECT_EQ(4, b.value());
+  EXPECT_EQ(2, (a + b).value());
+  EXPECT_EQ(1, (a - b).value());
+  EXPECT_EQ(6, (a * b).value());
+  EXPECT_EQ(2, (-a).value());
+  EXPECT_EQ(3, a.inverse().value());
+  EXPECT_EQ(1, a.pow(big_integer(6)).value());
+  EXPECT_EQ(a.inverse(), a.pow(big_integer(-1)));
+  EXPECT_EQ(p(1), a.pow(big_integer(0)));
+
+  big_integer two_64 = big_integer(1) << 64;
+  mod_context q(two_64);
+  mod_value c = q(two_64 - 1);
+  EXPECT_EQ(1, (c * c).value());
+  EXPECT_EQ(0, (c + q(1)).value());
+  EXPECT_EQ(two_64 - 1, c.inverse().value());
+  EXPECT_THROW(q(2).inverse(), std::domain_error);
+
+  mod_context one(big_integer(1));
+  EXPECT_EQ(0, (one(5) * one(3)).pow(big_integer(4)).value());
+  EXPECT_THROW(mod_context(big_integer(0)), std::domain_error);
+  EXPECT_THROW(a + c, std::invalid_argument);
+}
+
+TEST(correctness_random, mod_value) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer m = rand_big(rng() % 20 + 1);
+    if (itn % 2 == 0) {
+      m <<= static_cast<int>(rng() % 70);
+    }
+    if (m == 0) {
+      continue;
+    }
+    mod_context ctx(m);
+    big_integer x = rand_big(rng() % 40) * (rng() % 2 ? 1 : -1);
+    big_integer y = rand_big(rng() % 40) * (rng() % 2 ? 1 : -1);
+    big_integer e = rand_big(rng() % 4);
+    auto reduce = [&m](big_integer v) {
+      v %= m;
+      return v < 0 ? v + m : v;
+    };
+    mod_value a(ctx, x), b(ctx, y);
+    EXPECT_EQ(reduce(x), a.value());
+    EXPECT_EQ(reduce(x + y), (a + b).value());
+    EXPECT_EQ(reduce(x - y), (a - b).value());
+    EXPECT_EQ(reduce(x * y), (a * b).value());
+    EXPECT_EQ(powmod(x, e, m), a.pow(e).value());
+    mod_value c = a;
+    big_integer z = x;
+    for (size_t i = 0; i != 10; ++i) {
+      c *= b;
+      c -= a;
+      z = reduce(z * y - x);
+    }
+    EXPECT_EQ(z, c.value());
+    if (gcd(y, m) == 1) {
+      EXPECT_EQ(invert(y, m), b.inverse().value());
+    }
+  }
+}
+
+TEST(correctness_allocation, mod_value_steady_state) {
+  for (big_integer m : {(big_integer(1) << 1024) - 105, (big_integer(1) << 1024) - 106}) {
+    mod_context ctx(m);
+    mod_value a(ctx, rand_big(40)), b(ctx, rand_big(40)), c(ctx);
+    big_integer e = rand_big(4);
+    c = (a * b + a - b).pow(e) * -a;
+    limb_pool::reset_stats();
+    for (size_t i = 0; i != number_of_iterations; ++i) {
+      c = (a * b + a - b).pow(e) * -a;
+    }
+    limb_pool_stats stats = limb_pool::stats();
+    EXPECT_GT(stats.hits, 0u);
+    EXPECT_EQ(0u, stats.misses);
+    big_integer x = a.value(), y = b.value();
+    EXPECT_EQ(powmod(x * y + x - y, e, m) * (m - x) % m, c.value());
+  }
+}
+
+TEST(correctness, stream) {
+  std::ostringstream out;
+  big_integer a = big_integer("-1234567890123456789012345678901234567890");
+  out << a << ' ' << std::showpos << big_integer(0) << std::noshowpos << ' ';
+  out << std::hex << std::showbase << std::uppercase << (big_integer(1) << 64) << ' ' << std::nouppercase;
+  out << std::oct << big_integer(8) << ' ' << std::dec << std::noshowbase;
+  out << std::setw(6) << std::setfill('*') << big_integer(-42) << std::left << std::setw(5) << big_integer(7);
+  out << std::internal << std::setw(6) << big_integer(-1) << '|';
+  EXPECT_EQ("-1234567890123456789012345678901234567890 +0 0X10000000000000000 010 ***-427****-****1|", out.str());
+
+  std::istringstream in("  -1234567890123456789012345678901234567890 ff 0x1F -017 12abc - 5");
+  big_integer b, c, d, e, f, g;
+  in >> b >> std::hex >> c;
+  in.unsetf(std::ios_base::basefield);
+  in >> d >> e >> std::dec >> f;
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(255, c);
+  EXPECT_EQ(31, d);
+  EXPECT_EQ(-15, e);
+  EXPECT_EQ(12, f);
+  EXPECT_TRUE(in.good());
+  in >> g;
+  EXPECT_TRUE(in.fail());
+  EXPECT_EQ(0, g);
+}
+
+TEST(correctness_random, stream) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != 100 * number_of_iterations; ++itn) {
+    int64_t x = static_cast<int64_t>(static_cast<uint64_t>(rng()) << 32u | rng()) >> (rng() % 64);
+    std::ios_base::fmtflags flags[] = {std::ios_base::dec, std::ios_base::hex, std::ios_base::oct};
+    std::ios_base::fmtflags basefield = flags[itn % 3];
+    if (basefield != std::ios_base::dec) {
+      x = x < 0 ? -(x + 1) : x;
+    }
+    std::ios_base::fmtflags showbase = rng() % 2 ? std::ios_base::showbase : std::ios_base::fmtflags();
+    std::streamsize width = rng() % 30;
+    std::ostringstream expected, actual;
+    for (std::ostringstream *out : {&expected, &actual}) {
+      out->setf(basefield, std::ios_base::basefield);
+      out->setf(showbase);
+      out->width(width);
+    }
+    expected << x;
+    actual << big_integer(x);
+    EXPECT_EQ(expected.str(), actual.str());
+
+    big_integer y = rand_big(rng() % 40) * (rng() % 2 ? 1 : -1), z;
+    std::stringstream round;
+    round.setf(basefield, std::ios_base::basefield);
+    round << y;
+    round >> z;
+    EXPECT_EQ(y, z);
+    EXPECT_TRUE(round.eof());
+  }
+}
@@ -0,0 +1,75 @@
+#include "big_integer_view.h"
+
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Borrowed limbs are read as they lie in memory.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "big_integer_view needs a little-endian host");
+
+big_integer_view::big_integer_view(uint8_t const *data, size_t size, size_t& offset)
+    : value_(read(data, size, offset)) {}
+
+big_integer const& big_integer_view::value() const {
+    return value_;
+}
+
+big_integer_view::operator big_integer const&() const {
+    return value_;
+}
+
+// Returned as a prvalue, so that value_ is initialised with the borrowed limbs instead of a copy.
+big_integer big_integer_view::read(uint8_t const *data, size_t size, size_t& offset) {
+    size_t start = offset;
+    big_integer_detail::serialized_header h = big_integer_detail::read_header(data, size, offset);
+    if (h.small || reinterpret_cast<uintptr_t>(h.limbs) % alignof(uint32_t) != 0) {
+        offset = start;
+        return deserialize(data, size, offset);
+    }
+    // leading zero limbs are left out of the borrowed range, as deserialize would drop them
+    auto limbs = reinterpret_cast<uint32_t const*>(h.limbs);
+    size_t n = h.value;
+    while (n > 1 && limbs[n - 1] == 0) {
+        --n;
+    }
+    return big_integer(storage_t::borrowed_limbs{limbs, n}, h.sign && (n > 1 || limbs[0] != 0));
+}
+
+mapped_file::mapped_file(std::string const& path) : data_(nullptr), size_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int e = errno;
+        close(fd);
+        throw std::system_error(e, std::generic_category(), path);
+    }
+    size_ = st.st_size;
+    if (size_ != 0) {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    int e = errno;
+    close(fd);
+    if (data_ == MAP_FAILED) {
+        throw std::system_error(e, std::generic_category(), path);
+    }
+}
+
+mapped_file::~mapped_file() {
+    if (size_ != 0) {
+        munmap(data_, size_);
+    }
+}
+
+uint8_t const* mapped_file::data() const {
+    return static_cast<uint8_t const*>(data_);
+}
+
+size_t mapped_file::size() const {
+    return size_;
+}
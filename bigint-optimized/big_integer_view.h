@@ -0,0 +1,45 @@
+#ifndef BIG_INTEGER_VIEW_H
+#define BIG_INTEGER_VIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "big_integer.h"
+
+// Read-only big_integer over a record written by serialize. Limbs at a 4-aligned address are used
+// in place, so the buffer must outlive the view; copies of the value own their limbs. The view
+// converts to big_integer const&, which covers comparison, to_string and right-hand operands.
+struct big_integer_view {
+    // reads the record at data + offset and moves offset past it, throws like deserialize
+    big_integer_view(uint8_t const *data, size_t size, size_t& offset);
+
+    big_integer_view(big_integer_view const&) = delete;
+    big_integer_view& operator=(big_integer_view const&) = delete;
+
+    big_integer const& value() const;
+    operator big_integer const&() const;
+
+private:
+    big_integer value_;
+
+    static big_integer read(uint8_t const *data, size_t size, size_t& offset);
+};
+
+// Whole file mapped read-only, for instance to put big_integer_views over.
+// Throws std::system_error if the file cannot be opened or mapped.
+struct mapped_file {
+    explicit mapped_file(std::string const& path);
+    ~mapped_file();
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    uint8_t const* data() const;
+    size_t size() const;
+
+private:
+    void *data_;
+    size_t size_;
+};
+
+#endif // BIG_INTEGER_VIEW_H
@@ -0,0 +1,113 @@
+#include "limb_resource.h"
+
+#include <algorithm>
+#include <new>
+
+namespace {
+size_t const MIN_CLASS_SHIFT = 5;
+size_t const CLASSES = 16;
+size_t const MAX_CACHED_BYTES = size_t(1) << 20;
+
+size_t class_bytes(size_t c) {
+    return size_t(1) << (MIN_CLASS_SHIFT + c);
+}
+
+size_t size_class(size_t bytes) {
+    size_t c = 0;
+    while (class_bytes(c) < bytes) {
+        ++c;
+    }
+    return c;
+}
+
+bool pooled(size_t bytes, size_t alignment) {
+    return bytes <= class_bytes(CLASSES - 1) && alignment <= alignof(std::max_align_t);
+}
+
+struct free_block {
+    free_block* next;
+};
+
+thread_local bool cache_destroyed = false;
+
+struct thread_cache {
+    free_block* lists[CLASSES] = {};
+    size_t cached[CLASSES] = {};
+    limb_pool_stats stats = {0, 0};
+
+    ~thread_cache() {
+        for (size_t c = 0; c < CLASSES; ++c) {
+            while (lists[c]) {
+                free_block* next = lists[c]->next;
+                ::operator delete(lists[c]);
+                lists[c] = next;
+            }
+        }
+        cache_destroyed = true;
+    }
+};
+
+thread_local thread_cache cache;
+
+size_t max_cached(size_t c) {
+    return std::min<size_t>(64, std::max<size_t>(4, MAX_CACHED_BYTES / class_bytes(c)));
+}
+}
+
+limb_pool& limb_pool::instance() {
+    static limb_pool pool;
+    return pool;
+}
+
+limb_pool_stats limb_pool::stats() {
+    return cache_destroyed ? limb_pool_stats{0, 0} : cache.stats;
+}
+
+void limb_pool::reset_stats() {
+    if (!cache_destroyed) {
+        cache.stats = {0, 0};
+    }
+}
+
+void* limb_pool::do_allocate(size_t bytes, size_t alignment) {
+    if (!pooled(bytes, alignment)) {
+        if (!cache_destroyed) {
+            ++cache.stats.misses;
+        }
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    // pooled blocks always come from ::operator new, which is what do_deallocate returns them to
+    size_t c = size_class(bytes);
+    if (cache_destroyed) {
+        return ::operator new(class_bytes(c));
+    }
+    ++cache.stats.misses;
+    if (free_block* block = cache.lists[c]) {
+        cache.lists[c] = block->next;
+        --cache.cached[c];
+        --cache.stats.misses;
+        ++cache.stats.hits;
+        return block;
+    }
+    return ::operator new(class_bytes(c));
+}
+
+void limb_pool::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    if (!pooled(bytes, alignment)) {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        return;
+    }
+    size_t c = size_class(bytes);
+    if (cache_destroyed || cache.cached[c] == max_cached(c)) {
+        ::operator delete(p);
+        return;
+    }
+    free_block* block = static_cast<free_block*>(p);
+    block->next = cache.lists[c];
+    cache.lists[c] = block;
+    ++cache.cached[c];
+}
+
+bool limb_pool::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,145 @@
+#ifndef LIMB_RESOURCE_H
+#define LIMB_RESOURCE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+struct limb_pool_stats {
+    size_t hits;
+    size_t misses;
+};
+
+// Size-classed free lists kept per thread. A block freed on another thread joins the lists of that
+// thread, so the pool never locks. Requests above the largest class go straight to the heap.
+struct limb_pool : std::pmr::memory_resource {
+    static limb_pool& instance();
+
+    // Counters of the calling thread.
+    static limb_pool_stats stats();
+    static void reset_stats();
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+};
+
+namespace limb_resource_detail {
+inline thread_local std::pmr::memory_resource* current = nullptr;
+}
+
+// Resource new limb storage of this thread is allocated from.
+inline std::pmr::memory_resource* get_limb_resource() {
+    std::pmr::memory_resource* r = limb_resource_detail::current;
+    return r ? r : &limb_pool::instance();
+}
+
+// Buffers from such resources outlive any scope, so values living elsewhere may share them.
+inline bool is_persistent_resource(std::pmr::memory_resource* r) {
+    return r == &limb_pool::instance() || r == std::pmr::new_delete_resource() || r == std::pmr::get_default_resource();
+}
+
+// Zero-filled scratch space for arithmetic kernels, always taken from the pool.
+struct scratch_limbs {
+    explicit scratch_limbs(size_t size) : size_(size) {
+        data_ = static_cast<uint32_t*>(limb_pool::instance().allocate(bytes(), alignof(uint32_t)));
+        for (size_t i = 0; i < size_; ++i) {
+            data_[i] = 0;
+        }
+    }
+
+    scratch_limbs(scratch_limbs const&) = delete;
+    scratch_limbs& operator=(scratch_limbs const&) = delete;
+
+    ~scratch_limbs() {
+        limb_pool::instance().deallocate(data_, bytes(), alignof(uint32_t));
+    }
+
+    uint32_t* data() {
+        return data_;
+    }
+
+    uint32_t& operator[](size_t i) {
+        return data_[i];
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    uint32_t* data_;
+    size_t size_;
+
+    size_t bytes() const {
+        return (size_ ? size_ : 1) * sizeof(uint32_t);
+    }
+};
+
+// Installs r as the limb resource of this thread until the scope ends.
+struct limb_resource_scope {
+    explicit limb_resource_scope(std::pmr::memory_resource* r) : previous(limb_resource_detail::current) {
+        limb_resource_detail::current = r;
+    }
+
+    limb_resource_scope(limb_resource_scope const&) = delete;
+    limb_resource_scope& operator=(limb_resource_scope const&) = delete;
+
+    ~limb_resource_scope() {
+        limb_resource_detail::current = previous;
+    }
+
+private:
+    std::pmr::memory_resource* previous;
+};
+
+// Bump arena for temporaries: every big_integer created while it is alive takes its limbs from it
+// when it first needs them, and all of them are released at once when it is destroyed. Copying such
+// a value, or assigning it to a big_integer created outside of the arena, makes a deep copy from the
+// pool; values that still hold arena limbs must not outlive it, which debug builds check when the
+// arena is destroyed. Values that are still inline may, and take later limbs from the current resource.
+struct big_integer_arena {
+    explicit big_integer_arena(size_t initial_size = 4096)
+        : resource(initial_size, get_limb_resource()), counted(&resource), scope(&counted) {}
+
+    ~big_integer_arena() {
+        assert(counted.live == 0 && "big_integer with arena limbs outlives the arena");
+    }
+
+    std::pmr::memory_resource* get() {
+        return &counted;
+    }
+
+private:
+    // counts the blocks handed out and not yet returned
+    struct counting_resource : std::pmr::memory_resource {
+        explicit counting_resource(std::pmr::memory_resource* upstream) : upstream(upstream), live(0) {}
+
+        std::pmr::memory_resource* upstream;
+        size_t live;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            void* p = upstream->allocate(bytes, alignment);
+            ++live;
+            return p;
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            --live;
+            upstream->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::pmr::monotonic_buffer_resource resource;
+    counting_resource counted;
+    limb_resource_scope scope;
+};
+
+#endif // LIMB_RESOURCE_H
@@ -1,59 +1,77 @@
 #ifndef OPTIMIZED_VECTOR_H
 #define OPTIMIZED_VECTOR_H
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include "limb_resource.h"
 
+// InlineLimbs is the number of limbs stored in place before falling back to the shared heap buffer.
+// Limbs owned by someone else (a file mapping, say) can also be borrowed: they are read in place,
+// while the first change and every copy take a buffer of their own.
+template <size_t InlineLimbs>
 struct optimized_vector {
-    optimized_vector() : small_object(true), vector({}) {}
+    static_assert(InlineLimbs > 0, "optimized_vector needs at least one inline limb");
 
-    explicit optimized_vector(size_t size, uint32_t val = 0) : small_object(size <= 1), vector({}) {
+    static constexpr size_t INLINE_LIMBS = InlineLimbs;
+
+    struct borrowed_limbs {
+        uint32_t const *data;
+        size_t size;
+    };
+
+    optimized_vector() : small_object(true), borrowed_object(false), resource(creation_resource()), vector({}) {}
+
+    explicit optimized_vector(size_t size, uint32_t val = 0)
+        : small_object(size <= small_vector::SIZE), borrowed_object(false), resource(creation_resource()), vector({}) {
         if (small_object) {
             vector.small = small_vector(size, val);
         } else {
-            vector.big = new vector_with_count(size, val);
+            vector.big = make_big(size, val);
         }
     }
 
-    optimized_vector(optimized_vector const &other) : small_object(other.small_object), vector({}) {
+    // limbs must outlive the vector and every vector it is assigned to
+    explicit optimized_vector(borrowed_limbs limbs)
+        : small_object(false), borrowed_object(true), resource(creation_resource()), vector({}) {
+        vector.borrowed = limbs;
+    }
+
+    optimized_vector(optimized_vector const &other)
+        : small_object(other.small_object), borrowed_object(false), resource(copy_resource(other)), vector({}) {
         if (small_object) {
             vector.small = other.vector.small;
         } else {
-            vector.big = other.vector.big;
-            ++vector.big->count;
+            vector.big = share_or_copy(other);
         }
     }
 
     ~optimized_vector() {
-        if (!small_object) {
+        if (owns_big()) {
             delete_one();
         }
     }
 
     optimized_vector& operator=(optimized_vector const &other) {
-        if (small_object ^ other.small_object) {
-            if (small_object) {
-                convert_to_big();
-            } else {
-                prep_for_changes();
-                vector.big->data_.clear();
-                for (size_t i = 0; i < other.vector.small.size_; ++i) {
-                    vector.big->data_.push_back(other.vector.small.data_[i]);
-                }
-                vector.big->count = 1;
-                return *this;
+        if (other.small_object) {
+            if (owns_big()) {
+                delete_one();
             }
-        }
-        small_object = other.small_object;
-        if (small_object) {
+            small_object = true;
+            borrowed_object = false;
             vector.small = other.vector.small;
-        } else {
-            if (vector.big != other.vector.big) {
+        } else if (!owns_big() || other.borrowed_object || vector.big != other.vector.big) {
+            vector_with_count *next = share_or_copy(other);
+            if (owns_big()) {
                 delete_one();
-                vector.big = other.vector.big;
-                ++vector.big->count;
             }
+            small_object = false;
+            borrowed_object = false;
+            vector.big = next;
         }
         return *this;
     }
@@ -68,13 +86,25 @@ struct optimized_vector {
     }
 
     uint32_t const& operator[](size_t i) const {
+        return data()[i];
+    }
+
+    uint32_t* data() {
         if (small_object) {
-            return vector.small.data_[i];
+            return vector.small.data_;
         } else {
-            return vector.big->data_[i];
+            prep_for_changes();
+            return vector.big->data_.data();
         }
     }
 
+    uint32_t const* data() const {
+        if (small_object) {
+            return vector.small.data_;
+        }
+        return borrowed_object ? vector.borrowed.data : vector.big->data_.data();
+    }
+
     void push_back(uint32_t const val) {
         if (small_object) {
             if (vector.small.size_ == small_vector::SIZE) {
@@ -90,7 +120,14 @@ struct optimized_vector {
     }
 
     size_t size() const {
-        return small_object ? vector.small.size_ : vector.big->data_.size();
+        if (small_object) {
+            return vector.small.size_;
+        }
+        return borrowed_object ? vector.borrowed.size : vector.big->data_.size();
+    }
+
+    bool is_small() const {
+        return small_object;
     }
 
     void resize(size_t new_size, uint32_t val = 0) {
@@ -99,10 +136,13 @@ struct optimized_vector {
                 while (vector.small.size_ < new_size) {
                     vector.small.data_[vector.small.size_++] = val;
                 }
+                vector.small.size_ = new_size;
                 return;
             } else {
                 convert_to_big();
             }
+        } else {
+            prep_for_changes();
         }
         vector.big->data_.resize(new_size, val);
     }
@@ -117,7 +157,7 @@ struct optimized_vector {
     }
 
     uint32_t const& back() const {
-        return small_object ? vector.small.data_[vector.small.size_ - 1] : vector.big->data_.back();
+        return data()[size() - 1];
     }
 
     void pop_back() {
@@ -130,6 +170,9 @@ struct optimized_vector {
     }
 
     friend bool operator==(optimized_vector const& a, optimized_vector const& b) {
+        if (a.borrowed_object || b.borrowed_object) {
+            return a.size() == b.size() && (a.data() == b.data() || std::equal(a.data(), a.data() + a.size(), b.data()));
+        }
         if (a.small_object ^ b.small_object) {
             if (a.small_object) {
                 return b.vector.big->data_ == a.vector.small;
@@ -147,16 +190,23 @@ struct optimized_vector {
 
 private:
     struct vector_with_count {
-        std::vector <uint32_t> data_;
+        std::pmr::vector <uint32_t> data_;
         size_t count;
 
-        vector_with_count() : data_(), count(1) {}
-        vector_with_count(size_t size, uint32_t val) : data_(size, val), count(1) {}
-        vector_with_count(std::vector <uint32_t> const &other) : data_(other), count(1) {}
+        explicit vector_with_count(std::pmr::memory_resource *r) : data_(r), count(1) {}
+        vector_with_count(size_t size, uint32_t val, std::pmr::memory_resource *r) : data_(size, val, r), count(1) {}
+        vector_with_count(std::pmr::vector <uint32_t> const &other, std::pmr::memory_resource *r)
+            : data_(other, r), count(1) {}
+        vector_with_count(uint32_t const *first, uint32_t const *last, std::pmr::memory_resource *r)
+            : data_(first, last, r), count(1) {}
+
+        std::pmr::memory_resource* resource() const {
+            return data_.get_allocator().resource();
+        }
     };
 
     struct small_vector {
-        static constexpr size_t SIZE = (sizeof(vector_with_count) - sizeof(size_t)) / sizeof(uint32_t);
+        static constexpr size_t SIZE = InlineLimbs;
         uint32_t data_[SIZE];
         size_t size_;
 
@@ -175,7 +225,7 @@ private:
             return *this;
         }
 
-        friend bool operator==(std::vector<uint32_t> const& a, small_vector const& b) {
+        friend bool operator==(std::pmr::vector<uint32_t> const& a, small_vector const& b) {
             if (a.size() == b.size_) {
                 for (size_t i = 0; i < a.size(); ++i) {
                     if (a[i] != b.data_[i]) {
@@ -203,31 +253,85 @@ private:
     };
 
     bool small_object;
+    bool borrowed_object;
+    std::pmr::memory_resource *resource;
 
     union {
         small_vector small;
         vector_with_count *big;
+        borrowed_limbs borrowed;
     } vector;
 
+    bool owns_big() const {
+        return !small_object && !borrowed_object;
+    }
+
+    // Resource of the buffers of a value, fixed when it is made under a persistent one. Values made
+    // under a scoped resource (an arena) keep none and take their buffers from the resource that is
+    // current when one is needed, so that an inline value made in the scope may outlive it.
+    static std::pmr::memory_resource* creation_resource() {
+        std::pmr::memory_resource *r = get_limb_resource();
+        return is_persistent_resource(r) ? r : nullptr;
+    }
+
+    // A copy of a buffer from a scoped resource may outlive the scope, so it takes a buffer of its
+    // own from the pool instead of sharing.
+    static std::pmr::memory_resource* copy_resource(optimized_vector const &other) {
+        if (other.owns_big() && !is_persistent_resource(other.vector.big->resource())) {
+            return &limb_pool::instance();
+        }
+        return creation_resource();
+    }
+
+    std::pmr::memory_resource* buffer_resource() const {
+        return resource ? resource : get_limb_resource();
+    }
+
+    template <typename... Args>
+    vector_with_count* make_big(Args const&... args) const {
+        std::pmr::memory_resource *r = buffer_resource();
+        void *place = r->allocate(sizeof(vector_with_count), alignof(vector_with_count));
+        return new(place) vector_with_count(args..., r);
+    }
+
+    vector_with_count* share_or_copy(optimized_vector const &other) const {
+        if (other.borrowed_object) {
+            return make_big(other.vector.borrowed.data, other.vector.borrowed.data + other.vector.borrowed.size);
+        }
+        vector_with_count *big = other.vector.big;
+        std::pmr::memory_resource *r = big->resource();
+        if (r == buffer_resource() || is_persistent_resource(r)) {
+            ++big->count;
+            return big;
+        }
+        return make_big(big->data_);
+    }
+
     void prep_for_changes() {
-        if (vector.big->count != 1) {
+        if (borrowed_object) {
+            borrowed_limbs limbs = vector.borrowed;
+            borrowed_object = false;
+            vector.big = make_big(limbs.data, limbs.data + limbs.size);
+        } else if (vector.big->count != 1) {
             --vector.big->count;
-            vector.big = new vector_with_count(vector.big->data_);
+            vector.big = make_big(vector.big->data_);
         }
     }
 
     void delete_one() const {
-        --vector.big->count;
-        if (vector.big->count == 0) {
-            delete vector.big;
+        if (--vector.big->count == 0) {
+            std::pmr::memory_resource *r = vector.big->resource();
+            vector.big->~vector_with_count();
+            r->deallocate(vector.big, sizeof(vector_with_count), alignof(vector_with_count));
         }
     }
 
     void convert_to_big() {
         small_object = false;
         small_vector temp = vector.small;
-        vector.big = new vector_with_count();
-        for (size_t i = 0; i < small_vector::SIZE; ++i) {
+        vector.big = make_big();
+        vector.big->data_.reserve(small_vector::SIZE + 1);
+        for (size_t i = 0; i < temp.size_; ++i) {
             vector.big->data_.push_back(temp.data_[i]);
         }
     }
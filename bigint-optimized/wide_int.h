@@ -0,0 +1,492 @@
+#ifndef WIDE_INT_H
+#define WIDE_INT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include "big_integer.h"
+
+namespace big_integer_detail {
+__extension__ typedef unsigned __int128 uint128;
+
+constexpr size_t bit_length(uint64_t x) {
+    return x == 0 ? 0 : 64 - __builtin_clzll(x);
+}
+}
+
+// Integer of a fixed number of bits in two's complement, held in an array of 64-bit limbs on the
+// stack. Every loop runs over a compile-time count, so the compiler unrolls it, and all
+// operations except the conversions from and to big_integer are constexpr.
+// Arithmetic wraps around modulo 2^Bits; division rounds towards zero as for big_integer, and
+// >> of a negative signed value rounds down. Dividing by zero is undefined.
+template <size_t Bits, bool Signed = true>
+struct wide_int {
+    static_assert(Bits > 0 && Bits % 64 == 0, "wide_int needs a positive multiple of 64 bits");
+    static constexpr size_t LIMBS = Bits / 64;
+
+    constexpr wide_int() : data_() {}
+
+    template <typename T, big_integer_detail::if_machine_integer<T> = 0>
+    constexpr wide_int(T a) : data_() {
+        uint64_t fill = big_integer_detail::negative(a) ? UINT64_MAX : 0;
+        data_[0] = static_cast<uint64_t>(a);
+        for (size_t i = 1; i < LIMBS; ++i) {
+            data_[i] = fill;
+        }
+    }
+
+    // truncated or extended by the sign of a
+    template <size_t OtherBits, bool OtherSigned>
+    constexpr explicit wide_int(wide_int<OtherBits, OtherSigned> const& a) : data_() {
+        uint64_t fill = a.negative() ? UINT64_MAX : 0;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            data_[i] = i < a.LIMBS ? a.limb(i) : fill;
+        }
+    }
+
+    // a modulo 2^Bits
+    explicit wide_int(big_integer const& a);
+    explicit operator big_integer() const;
+
+    // limb i of the two's complement, the lowest first
+    constexpr uint64_t limb(size_t i) const {
+        return data_[i];
+    }
+
+    constexpr bool negative() const {
+        return Signed && data_[LIMBS - 1] >> 63u;
+    }
+
+    constexpr wide_int& operator+=(wide_int const& rhs) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            uint64_t s = data_[i] + rhs.data_[i], t = s + carry;
+            carry = (s < rhs.data_[i]) | (t < s);
+            data_[i] = t;
+        }
+        return *this;
+    }
+
+    constexpr wide_int& operator-=(wide_int const& rhs) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            uint64_t d = data_[i] - rhs.data_[i], t = d - borrow;
+            borrow = (data_[i] < rhs.data_[i]) | (d < borrow);
+            data_[i] = t;
+        }
+        return *this;
+    }
+
+    // only the products landing in the low Bits are formed
+    constexpr wide_int& operator*=(wide_int const& rhs) {
+        wide_int res;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            uint64_t carry = 0;
+            for (size_t j = 0; i + j < LIMBS; ++j) {
+                uint128 t = static_cast<uint128>(data_[i]) * rhs.data_[j] + res.data_[i + j] + carry;
+                res.data_[i + j] = static_cast<uint64_t>(t);
+                carry = static_cast<uint64_t>(t >> 64u);
+            }
+        }
+        return *this = res;
+    }
+
+    constexpr wide_int& operator/=(wide_int const& rhs) {
+        wide_int q, r;
+        divmod(*this, rhs, q, r);
+        return *this = q;
+    }
+
+    constexpr wide_int& operator%=(wide_int const& rhs) {
+        wide_int q, r;
+        divmod(*this, rhs, q, r);
+        return *this = r;
+    }
+
+    constexpr wide_int& operator&=(wide_int const& rhs) {
+        for (size_t i = 0; i < LIMBS; ++i) {
+            data_[i] &= rhs.data_[i];
+        }
+        return *this;
+    }
+
+    constexpr wide_int& operator|=(wide_int const& rhs) {
+        for (size_t i = 0; i < LIMBS; ++i) {
+            data_[i] |= rhs.data_[i];
+        }
+        return *this;
+    }
+
+    constexpr wide_int& operator^=(wide_int const& rhs) {
+        for (size_t i = 0; i < LIMBS; ++i) {
+            data_[i] ^= rhs.data_[i];
+        }
+        return *this;
+    }
+
+    constexpr wide_int& operator<<=(int rhs) {
+        size_t words = static_cast<size_t>(rhs) / 64, bits = static_cast<size_t>(rhs) % 64;
+        for (size_t i = LIMBS; i-- > 0;) {
+            uint64_t hi = i >= words ? data_[i - words] : 0;
+            uint64_t lo = i >= words + 1 ? data_[i - words - 1] : 0;
+            data_[i] = bits == 0 ? hi : hi << bits | lo >> (64 - bits);
+        }
+        return *this;
+    }
+
+    constexpr wide_int& operator>>=(int rhs) {
+        size_t words = static_cast<size_t>(rhs) / 64, bits = static_cast<size_t>(rhs) % 64;
+        uint64_t fill = negative() ? UINT64_MAX : 0;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            uint64_t lo = i + words < LIMBS ? data_[i + words] : fill;
+            uint64_t hi = i + words + 1 < LIMBS ? data_[i + words + 1] : fill;
+            data_[i] = bits == 0 ? lo : lo >> bits | hi << (64 - bits);
+        }
+        return *this;
+    }
+
+    constexpr wide_int operator+() const {
+        return *this;
+    }
+
+    constexpr wide_int operator-() const {
+        return ~*this + 1;
+    }
+
+    constexpr wide_int operator~() const {
+        wide_int res;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            res.data_[i] = ~data_[i];
+        }
+        return res;
+    }
+
+    constexpr wide_int& operator++() {
+        return *this += 1;
+    }
+
+    constexpr wide_int operator++(int) {
+        wide_int res = *this;
+        ++*this;
+        return res;
+    }
+
+    constexpr wide_int& operator--() {
+        return *this -= 1;
+    }
+
+    constexpr wide_int operator--(int) {
+        wide_int res = *this;
+        --*this;
+        return res;
+    }
+
+    // number of significant bits of the magnitude, 0 for zero
+    constexpr size_t bit_length() const {
+        return negative() ? (-*this).bit_length_unsigned() : bit_length_unsigned();
+    }
+
+    friend constexpr wide_int operator+(wide_int a, wide_int const& b) {
+        return a += b;
+    }
+
+    friend constexpr wide_int operator-(wide_int a, wide_int const& b) {
+        return a -= b;
+    }
+
+    friend constexpr wide_int operator*(wide_int a, wide_int const& b) {
+        return a *= b;
+    }
+
+    friend constexpr wide_int operator/(wide_int a, wide_int const& b) {
+        return a /= b;
+    }
+
+    friend constexpr wide_int operator%(wide_int a, wide_int const& b) {
+        return a %= b;
+    }
+
+    friend constexpr wide_int operator&(wide_int a, wide_int const& b) {
+        return a &= b;
+    }
+
+    friend constexpr wide_int operator|(wide_int a, wide_int const& b) {
+        return a |= b;
+    }
+
+    friend constexpr wide_int operator^(wide_int a, wide_int const& b) {
+        return a ^= b;
+    }
+
+    friend constexpr wide_int operator<<(wide_int a, int b) {
+        return a <<= b;
+    }
+
+    friend constexpr wide_int operator>>(wide_int a, int b) {
+        return a >>= b;
+    }
+
+    // -1, 0 or 1 as a is less than, equal to or greater than b
+    friend constexpr int compare(wide_int const& a, wide_int const& b) {
+        for (size_t i = LIMBS; i-- > 0;) {
+            // flipping the sign bit of the top limb turns the signed comparison into an unsigned one
+            uint64_t flip = Signed && i + 1 == LIMBS ? uint64_t(1) << 63u : 0;
+            uint64_t x = a.data_[i] ^ flip, y = b.data_[i] ^ flip;
+            if (x != y) {
+                return x < y ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    friend constexpr bool operator==(wide_int const& a, wide_int const& b) {
+        return compare(a, b) == 0;
+    }
+
+    friend constexpr bool operator!=(wide_int const& a, wide_int const& b) {
+        return compare(a, b) != 0;
+    }
+
+    friend constexpr bool operator<(wide_int const& a, wide_int const& b) {
+        return compare(a, b) < 0;
+    }
+
+    friend constexpr bool operator>(wide_int const& a, wide_int const& b) {
+        return compare(a, b) > 0;
+    }
+
+    friend constexpr bool operator<=(wide_int const& a, wide_int const& b) {
+        return compare(a, b) <= 0;
+    }
+
+    friend constexpr bool operator>=(wide_int const& a, wide_int const& b) {
+        return compare(a, b) >= 0;
+    }
+
+    friend std::string to_string(wide_int const& a) {
+        return ::to_string(big_integer(a));
+    }
+
+    friend std::ostream& operator<<(std::ostream& s, wide_int const& a) {
+        return s << to_string(a);
+    }
+
+private:
+    using uint128 = big_integer_detail::uint128;
+
+    uint64_t data_[LIMBS];
+
+    constexpr size_t bit_length_unsigned() const {
+        for (size_t i = LIMBS; i-- > 0;) {
+            if (data_[i] != 0) {
+                return 64 * i + big_integer_detail::bit_length(data_[i]);
+            }
+        }
+        return 0;
+    }
+
+    // Algorithm D on magnitudes, so that the minimum of a signed type still divides as 2^(Bits - 1).
+    // Quotient digits are whole limbs estimated from a 128 by 64 bit division.
+    static constexpr void divmod_unsigned(wide_int const& u, wide_int const& v, wide_int& q, wide_int& r) {
+        size_t n = (v.bit_length_unsigned() + 63) / 64, m = (u.bit_length_unsigned() + 63) / 64;
+        if (LIMBS == 1 || n <= 1) {
+            uint64_t d = v.data_[0], rem = 0;
+            for (size_t i = m; i-- > 0;) {
+                uint128 cur = static_cast<uint128>(rem) << 64u | u.data_[i];
+                q.data_[i] = static_cast<uint64_t>(cur / d);
+                rem = static_cast<uint64_t>(cur % d);
+            }
+            r.data_[0] = rem;
+            return;
+        }
+        if (m < n) {
+            r = u;
+            return;
+        }
+        // normalised so that the top limb of the divisor has its high bit set
+        size_t shift = 64 - big_integer_detail::bit_length(v.data_[n - 1]);
+        wide_int d = v << static_cast<int>(shift);
+        uint64_t w[LIMBS + 1] = {};
+        for (size_t i = 0; i < m; ++i) {
+            w[i] = u.data_[i];
+        }
+        shift_left_limbs(w, m + 1, shift);
+        for (size_t j = m - n + 1; j-- > 0;) {
+            uint128 top = static_cast<uint128>(w[j + n]) << 64u | w[j + n - 1];
+            uint128 qt = top / d.data_[n - 1], rt = top % d.data_[n - 1];
+            while (qt >> 64u || qt * d.data_[n - 2] > (rt << 64u | w[j + n - 2])) {
+                --qt;
+                rt += d.data_[n - 1];
+                if (rt >> 64u) {
+                    break;
+                }
+            }
+            uint64_t carry = 0, borrow = 0;
+            for (size_t i = 0; i <= n; ++i) {
+                uint128 p = i < n ? qt * d.data_[i] + carry : carry;
+                uint64_t lo = static_cast<uint64_t>(p), x = w[i + j], t = x - lo - borrow;
+                borrow = (x < lo) | (x - lo < borrow);
+                carry = static_cast<uint64_t>(p >> 64u);
+                w[i + j] = t;
+            }
+            if (borrow) {
+                // the estimate was one too large
+                --qt;
+                carry = 0;
+                for (size_t i = 0; i <= n; ++i) {
+                    uint128 s = static_cast<uint128>(w[i + j]) + (i < n ? d.data_[i] : 0) + carry;
+                    w[i + j] = static_cast<uint64_t>(s);
+                    carry = static_cast<uint64_t>(s >> 64u);
+                }
+            }
+            q.data_[j] = static_cast<uint64_t>(qt);
+        }
+        shift_right_limbs(w, n, shift);
+        for (size_t i = 0; i < n; ++i) {
+            r.data_[i] = w[i];
+        }
+    }
+
+    static constexpr void divmod(wide_int const& a, wide_int const& b, wide_int& q, wide_int& r) {
+        bool a_negative = a.negative(), b_negative = b.negative();
+        divmod_unsigned(a_negative ? -a : a, b_negative ? -b : b, q, r);
+        if (a_negative != b_negative) {
+            q = -q;
+        }
+        if (a_negative) {
+            r = -r;
+        }
+    }
+
+    static constexpr void shift_left_limbs(uint64_t *w, size_t n, size_t shift) {
+        for (size_t i = n; shift != 0 && i-- > 0;) {
+            w[i] = w[i] << shift | (i > 0 ? w[i - 1] >> (64 - shift) : 0);
+        }
+    }
+
+    static constexpr void shift_right_limbs(uint64_t *w, size_t n, size_t shift) {
+        for (size_t i = 0; shift != 0 && i < n; ++i) {
+            w[i] = w[i] >> shift | w[i + 1] << (64 - shift);
+        }
+    }
+};
+
+template <size_t Bits>
+using wide_uint = wide_int<Bits, false>;
+
+template <size_t Bits, bool Signed>
+wide_int<Bits, Signed>::wide_int(big_integer const& a) : data_() {
+    size_t n = std::min(a.data_.size(), 2 * LIMBS);
+    uint32_t const *m = a.data_.data();
+    for (size_t i = 0; i < n; ++i) {
+        data_[i / 2] |= static_cast<uint64_t>(m[i]) << (32 * (i % 2));
+    }
+    if (a.sign) {
+        *this = -*this;
+    }
+}
+
+template <size_t Bits, bool Signed>
+wide_int<Bits, Signed>::operator big_integer() const {
+    big_integer res;
+    res.sign = negative();
+    wide_int m = res.sign ? -*this : *this;
+    res.data_.resize(2 * LIMBS);
+    uint32_t *r = res.data_.data();
+    for (size_t i = 0; i < LIMBS; ++i) {
+        r[2 * i] = static_cast<uint32_t>(m.data_[i]);
+        r[2 * i + 1] = static_cast<uint32_t>(m.data_[i] >> 32u);
+    }
+    res.remove_zeros();
+    return res;
+}
+
+// Value of a _bi literal, computed while compiling. It converts implicitly to big_integer by copying
+// the limbs, and to a wide_int while still compiling.
+template <size_t Bits>
+struct big_integer_literal {
+    wide_uint<Bits> magnitude;
+    bool negative;
+
+    constexpr big_integer_literal operator-() const {
+        return {magnitude, !negative && magnitude != 0};
+    }
+
+    operator big_integer() const {
+        big_integer res(magnitude);
+        return negative ? -res : res;
+    }
+
+    template <size_t OtherBits, bool Signed>
+    constexpr explicit operator wide_int<OtherBits, Signed>() const {
+        wide_int<OtherBits, Signed> res(magnitude);
+        return negative ? -res : res;
+    }
+};
+
+namespace big_integer_detail {
+struct literal_format {
+    uint32_t base;
+    size_t prefix;
+    size_t digits;
+};
+
+template <size_t N>
+constexpr literal_format parse_format(char const (&s)[N]) {
+    literal_format res{10, 0, 0};
+    if (N > 1 && s[0] == '0') {
+        bool hex = N > 2 && (s[1] == 'x' || s[1] == 'X'), binary = N > 2 && (s[1] == 'b' || s[1] == 'B');
+        res = hex ? literal_format{16, 2, 0} : binary ? literal_format{2, 2, 0} : literal_format{8, 1, 0};
+    }
+    for (size_t i = res.prefix; i < N; ++i) {
+        res.digits += s[i] != '\'';
+    }
+    return res;
+}
+
+// enough bits for any number of that many digits: log2(10) < 10 / 3
+constexpr size_t literal_bits(literal_format f) {
+    size_t bits = f.base == 16 ? 4 * f.digits : f.base == 8 ? 3 * f.digits : f.base == 2 ? f.digits : f.digits * 10 / 3 + 1;
+    return (bits + 63) / 64 * 64;
+}
+
+constexpr uint32_t digit_value(char c) {
+    return c <= '9' ? c - '0' : c <= 'F' ? c - 'A' + 10 : c - 'a' + 10;
+}
+
+// Digits are gathered into a machine word first, so that the wide multiplication runs only
+// once per word.
+template <size_t Bits, size_t N>
+constexpr wide_uint<Bits> parse_literal(char const (&s)[N], literal_format f) {
+    wide_uint<Bits> res;
+    uint64_t word = 0, scale = 1;
+    for (size_t i = f.prefix; i < N; ++i) {
+        if (s[i] == '\'') {
+            continue;
+        }
+        word = word * f.base + digit_value(s[i]);
+        scale *= f.base;
+        if (scale > UINT64_MAX / 16 / f.base) {
+            res = res * scale + word;
+            word = 0;
+            scale = 1;
+        }
+    }
+    return res * scale + word;
+}
+}
+
+// 123_bi, 0xffff'ffff'ffff'ffff'ffff_bi: any integer literal, with no limit on the length,
+// becomes a big_integer_literal without parsing at run time.
+template <char... Chars>
+constexpr auto operator""_bi() {
+    constexpr char digits[] = {Chars...};
+    constexpr big_integer_detail::literal_format format = big_integer_detail::parse_format(digits);
+    constexpr size_t bits = big_integer_detail::literal_bits(format);
+    return big_integer_literal<bits>{big_integer_detail::parse_literal<bits>(digits, format), false};
+}
+
+#endif // WIDE_INT_H